@@ -7,6 +7,7 @@
  */
 #include "breezebutton.h"
 #include "breeze.h"
+#include "breezebuttoniconcache.h"
 #include "colortools.h"
 #include "geometrytools.h"
 #include "renderdecorationbuttonicon.h"
@@ -21,7 +22,7 @@
 
 #include <QPainter>
 #include <QPainterPath>
-#include <QVariantAnimation>
+#include <QtMath>
 
 namespace Breeze
 {
@@ -33,18 +34,17 @@ using KDecoration2::ColorRole;
 Button::Button(KDecoration2::DecorationButtonType type, Decoration *decoration, QObject *parent)
     : DecorationButton(type, decoration, parent)
     , m_d(qobject_cast<Decoration *>(decoration))
-    , m_animation(new QVariantAnimation(this))
+    , m_animation(new ClockedAnimation(this))
     , m_isGtkCsdButton(false)
 {
     auto c = decoration->client();
 
     // setup animation
-    // It is important start and end value are of the same type, hence 0.0 and not just 0
     m_animation->setStartValue(0.0);
     m_animation->setEndValue(1.0);
     m_animation->setEasingCurve(QEasingCurve::InOutQuad);
-    connect(m_animation, &QVariantAnimation::valueChanged, this, [this](const QVariant &value) {
-        setOpacity(value.toReal());
+    connect(m_animation, &ClockedAnimation::valueChanged, this, [this](qreal value) {
+        setOpacity(value);
     });
 
     // detect the kde-gtk-config-daemon
@@ -286,6 +286,10 @@ void Button::drawIcon(QPainter *painter) const
                                  || (m_devicePixelRatio <= 1.001
                                      && (m_d->buttonBackgroundType() == ButtonBackgroundType::Small
                                          || m_d->internalSettings()->iconSize() < InternalSettings::EnumIconSize::IconLargeMedium)));
+
+        if (drawCachedIcon(painter, iconWidth, deviceOffsetDecorationTopLeftToIconTopLeft, forceEvenSquares))
+            return;
+
         auto [iconRenderer, localRenderingWidth] = RenderDecorationButtonIcon::factory(m_d->internalSettings(),
                                                                                        painter,
                                                                                        false,
@@ -304,6 +308,83 @@ void Button::drawIcon(QPainter *painter) const
     }
 }
 
+//__________________________________________________________________
+bool Button::drawCachedIcon(QPainter *painter, const qreal iconWidth, const QPointF &deviceOffsetDecorationTopLeftToIconTopLeft, const bool forceEvenSquares) const
+{
+    // GTK/standalone buttons are one-off renders, and animated colours would only churn the cache
+    if (m_isGtkCsdButton || isStandAlone() || m_animation->state() == QAbstractAnimation::Running
+        || m_d->activeStateChangeAnimation()->state() == QAbstractAnimation::Running)
+        return false;
+
+    // the cached image can only be blitted 1:1 onto the device for an unrotated, uniformly-scaled painter
+    const QTransform deviceTransform = painter->deviceTransform();
+    if (deviceTransform.type() > QTransform::TxScale || !qFuzzyCompare(deviceTransform.m11(), deviceTransform.m22()) || deviceTransform.m11() <= 0)
+        return false;
+
+    const qreal deviceScale = deviceTransform.m11();
+    const QPointF deviceOrigin = deviceTransform.map(QPointF(0, 0));
+    const QPoint deviceOriginFloor(qFloor(deviceOrigin.x()), qFloor(deviceOrigin.y()));
+    const QPointF snapOffsetFloor(qFloor(deviceOffsetDecorationTopLeftToIconTopLeft.x()), qFloor(deviceOffsetDecorationTopLeftToIconTopLeft.y()));
+
+    ButtonIconKey key;
+    key.iconStyle = m_d->internalSettings()->buttonIconStyle();
+    key.buttonType = static_cast<int>(type());
+    key.checked = isChecked();
+    key.boldButtonIcons = m_boldButtonIcons;
+    key.forceEvenSquares = forceEvenSquares;
+    key.iconWidth = iconWidth;
+    key.devicePixelRatio = m_devicePixelRatio;
+    key.deviceScale = deviceScale;
+    key.penWidth = painter->pen().widthF();
+    key.foregroundColor = painter->pen().color().rgba64();
+    key.phaseX = qRound((deviceOrigin.x() - deviceOriginFloor.x()) * ButtonIconKey::s_subpixelSteps);
+    key.phaseY = qRound((deviceOrigin.y() - deviceOriginFloor.y()) * ButtonIconKey::s_subpixelSteps);
+    key.snapOffsetX = qRound((deviceOffsetDecorationTopLeftToIconTopLeft.x() - snapOffsetFloor.x()) * ButtonIconKey::s_subpixelSteps);
+    key.snapOffsetY = qRound((deviceOffsetDecorationTopLeftToIconTopLeft.y() - snapOffsetFloor.y()) * ButtonIconKey::s_subpixelSteps);
+
+    // room for strokes which extend beyond the icon square
+    const int margin = qCeil(iconWidth * deviceScale / 4) + 2;
+
+    QImage image = ButtonIconCache::self().icon(key);
+    if (image.isNull()) {
+        const int imageSize = qCeil(iconWidth * deviceScale) + 2 * margin;
+        image = QImage(imageSize, imageSize, QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+
+        const QPointF phase(qreal(key.phaseX) / ButtonIconKey::s_subpixelSteps, qreal(key.phaseY) / ButtonIconKey::s_subpixelSteps);
+        // the renderer only uses the fractional part of the offset for pixel-snapping;
+        // an integer bias keeps it positive so that the snapping rounds the same way as the direct render
+        const QPointF snapOffset(qreal(key.snapOffsetX) / ButtonIconKey::s_subpixelSteps + 64, qreal(key.snapOffsetY) / ButtonIconKey::s_subpixelSteps + 64);
+
+        QPainter iconPainter(&image);
+        iconPainter.setRenderHints(QPainter::Antialiasing);
+        iconPainter.setWorldTransform(QTransform(deviceScale, 0, 0, deviceScale, margin + phase.x(), margin + phase.y()));
+        iconPainter.setPen(painter->pen());
+
+        auto [iconRenderer, localRenderingWidth] = RenderDecorationButtonIcon::factory(m_d->internalSettings(),
+                                                                                       &iconPainter,
+                                                                                       false,
+                                                                                       m_boldButtonIcons,
+                                                                                       m_devicePixelRatio,
+                                                                                       snapOffset,
+                                                                                       forceEvenSquares);
+        qreal scaleFactor = iconWidth / localRenderingWidth;
+        iconPainter.scale(scaleFactor, scaleFactor);
+        iconRenderer->renderIcon(static_cast<DecorationButtonType>(type()), isChecked());
+        iconPainter.end();
+
+        ButtonIconCache::self().insert(key, image);
+    }
+
+    // blit in device pixels
+    const qreal paintDeviceDevicePixelRatio = painter->device()->devicePixelRatioF();
+    painter->save();
+    painter->setWorldTransform(QTransform::fromScale(1 / paintDeviceDevicePixelRatio, 1 / paintDeviceDevicePixelRatio));
+    painter->drawImage(deviceOriginFloor - QPoint(margin, margin), image);
+    painter->restore();
+    return true;
+}
+
 //__________________________________________________________________
 QColor Button::foregroundColor(const bool getNonAnimatedColor) const
 {
@@ -326,6 +407,11 @@ QColor Button::foregroundColor(const bool getNonAnimatedColor) const
             return foregroundPressActiveStateAnimated(active, getNonAnimatedColor);
         }
     } else if (m_animation->state() == QAbstractAnimation::Running && !getNonAnimatedColor) { // button hover animation
+        if (m_d->activeStateChangeAnimation()->state() != QAbstractAnimation::Running) {
+            return m_buttonPalette->hoverRampColor(ButtonComponent::Icon, active, m_opacity);
+        }
+
+        // hover and active state change animations at once
         QColor foregroundNormal = foregroundNormalActiveStateAnimated(active, getNonAnimatedColor);
         QColor foregroundHover = foregroundHoverActiveStateAnimated(active, getNonAnimatedColor);
         if (foregroundNormal.isValid() && foregroundHover.isValid()) {
@@ -344,17 +430,7 @@ QColor Button::foregroundColor(const bool getNonAnimatedColor) const
 QColor Button::foregroundNormalActiveStateAnimated(const bool active, const bool getNonAnimatedColor) const
 {
     if (!getNonAnimatedColor && m_d->activeStateChangeAnimation()->state() == QAbstractAnimation::Running) {
-        if (m_buttonPalette->active()->foregroundNormal.isValid() && m_buttonPalette->inactive()->foregroundNormal.isValid()) {
-            return KColorUtils::mix(m_buttonPalette->inactive()->foregroundNormal,
-                                    m_buttonPalette->active()->foregroundNormal,
-                                    m_d->activeStateChangeAnimationOpacity());
-        } else if (m_buttonPalette->active()->foregroundNormal.isValid() && !m_buttonPalette->inactive()->foregroundNormal.isValid()) {
-            return ColorTools::alphaMix(m_buttonPalette->active()->foregroundNormal, m_d->activeStateChangeAnimationOpacity());
-        } else if (!m_buttonPalette->active()->foregroundNormal.isValid() && m_buttonPalette->inactive()->foregroundNormal.isValid()) {
-            return ColorTools::alphaMix(m_buttonPalette->inactive()->foregroundNormal, (1.0 - m_d->activeStateChangeAnimationOpacity()));
-        } else {
-            return QColor();
-        }
+        return m_buttonPalette->activeStateRampColor(OverridableButtonColorState::IconNormal, m_d->activeStateChangeAnimationOpacity());
     } else {
         const DecorationButtonPaletteGroup *group = active ? m_buttonPalette->active() : m_buttonPalette->inactive();
         return group->foregroundNormal;
@@ -364,17 +440,7 @@ QColor Button::foregroundNormalActiveStateAnimated(const bool active, const bool
 QColor Button::foregroundHoverActiveStateAnimated(const bool active, const bool getNonAnimatedColor) const
 {
     if (!getNonAnimatedColor && m_d->activeStateChangeAnimation()->state() == QAbstractAnimation::Running) {
-        if (m_buttonPalette->active()->foregroundHover.isValid() && m_buttonPalette->inactive()->foregroundHover.isValid()) {
-            return KColorUtils::mix(m_buttonPalette->inactive()->foregroundHover,
-                                    m_buttonPalette->active()->foregroundHover,
-                                    m_d->activeStateChangeAnimationOpacity());
-        } else if (m_buttonPalette->active()->foregroundHover.isValid() && !m_buttonPalette->inactive()->foregroundHover.isValid()) {
-            return ColorTools::alphaMix(m_buttonPalette->active()->foregroundHover, m_d->activeStateChangeAnimationOpacity());
-        } else if (!m_buttonPalette->active()->foregroundHover.isValid() && m_buttonPalette->inactive()->foregroundHover.isValid()) {
-            return ColorTools::alphaMix(m_buttonPalette->inactive()->foregroundHover, (1.0 - m_d->activeStateChangeAnimationOpacity()));
-        } else {
-            return QColor();
-        }
+        return m_buttonPalette->activeStateRampColor(OverridableButtonColorState::IconHover, m_d->activeStateChangeAnimationOpacity());
     } else {
         const DecorationButtonPaletteGroup *group = active ? m_buttonPalette->active() : m_buttonPalette->inactive();
         return group->foregroundHover;
@@ -384,16 +450,7 @@ QColor Button::foregroundHoverActiveStateAnimated(const bool active, const bool
 QColor Button::foregroundPressActiveStateAnimated(const bool active, const bool getNonAnimatedColor) const
 {
     if (!getNonAnimatedColor && m_d->activeStateChangeAnimation()->state() == QAbstractAnimation::Running) {
-        if (m_buttonPalette->active()->foregroundPress.isValid() && m_buttonPalette->inactive()->foregroundPress.isValid()) {
-            return KColorUtils::mix(m_buttonPalette->inactive()->foregroundPress,
-                                    m_buttonPalette->active()->foregroundPress,
-                                    m_d->activeStateChangeAnimationOpacity());
-        } else if (m_buttonPalette->active()->foregroundPress.isValid() && !m_buttonPalette->inactive()->foregroundPress.isValid()) {
-            return ColorTools::alphaMix(m_buttonPalette->active()->foregroundPress, m_d->activeStateChangeAnimationOpacity());
-        } else if (!m_buttonPalette->active()->foregroundPress.isValid() && m_buttonPalette->inactive()->foregroundPress.isValid()) {
-            return ColorTools::alphaMix(m_buttonPalette->inactive()->foregroundPress, (1.0 - m_d->activeStateChangeAnimationOpacity()));
-        } else
-            return QColor();
+        return m_buttonPalette->activeStateRampColor(OverridableButtonColorState::IconPress, m_d->activeStateChangeAnimationOpacity());
     } else {
         const DecorationButtonPaletteGroup *group = active ? m_buttonPalette->active() : m_buttonPalette->inactive();
         return group->foregroundPress;
@@ -423,6 +480,11 @@ QColor Button::backgroundColor(const bool getNonAnimatedColor) const
             return backgroundPressActiveStateAnimated(active, getNonAnimatedColor);
         }
     } else if (m_animation->state() == QAbstractAnimation::Running && !getNonAnimatedColor) { // button hover animation
+        if (m_d->activeStateChangeAnimation()->state() != QAbstractAnimation::Running) {
+            return m_buttonPalette->hoverRampColor(ButtonComponent::Background, active, m_opacity);
+        }
+
+        // hover and active state change animations at once
         QColor backgroundNormal = backgroundNormalActiveStateAnimated(active, getNonAnimatedColor);
         QColor backgroundHover = backgroundHoverActiveStateAnimated(active, getNonAnimatedColor);
         if (backgroundNormal.isValid() && backgroundHover.isValid()) {
@@ -441,17 +503,7 @@ QColor Button::backgroundColor(const bool getNonAnimatedColor) const
 QColor Button::backgroundNormalActiveStateAnimated(const bool active, const bool getNonAnimatedColor) const
 {
     if (!getNonAnimatedColor && m_d->activeStateChangeAnimation()->state() == QAbstractAnimation::Running) {
-        if (m_buttonPalette->active()->backgroundNormal.isValid() && m_buttonPalette->inactive()->backgroundNormal.isValid()) {
-            return KColorUtils::mix(m_buttonPalette->inactive()->backgroundNormal,
-                                    m_buttonPalette->active()->backgroundNormal,
-                                    m_d->activeStateChangeAnimationOpacity());
-        } else if (m_buttonPalette->active()->backgroundNormal.isValid() && !m_buttonPalette->inactive()->backgroundNormal.isValid()) {
-            return ColorTools::alphaMix(m_buttonPalette->active()->backgroundNormal, m_d->activeStateChangeAnimationOpacity());
-        } else if (!m_buttonPalette->active()->backgroundNormal.isValid() && m_buttonPalette->inactive()->backgroundNormal.isValid()) {
-            return ColorTools::alphaMix(m_buttonPalette->inactive()->backgroundNormal, (1.0 - m_d->activeStateChangeAnimationOpacity()));
-        } else {
-            return QColor();
-        }
+        return m_buttonPalette->activeStateRampColor(OverridableButtonColorState::BackgroundNormal, m_d->activeStateChangeAnimationOpacity());
     } else {
         const DecorationButtonPaletteGroup *group = active ? m_buttonPalette->active() : m_buttonPalette->inactive();
         return group->backgroundNormal;
@@ -461,17 +513,7 @@ QColor Button::backgroundNormalActiveStateAnimated(const bool active, const bool
 QColor Button::backgroundHoverActiveStateAnimated(const bool active, const bool getNonAnimatedColor) const
 {
     if (!getNonAnimatedColor && m_d->activeStateChangeAnimation()->state() == QAbstractAnimation::Running) {
-        if (m_buttonPalette->active()->backgroundHover.isValid() && m_buttonPalette->inactive()->backgroundHover.isValid()) {
-            return KColorUtils::mix(m_buttonPalette->inactive()->backgroundHover,
-                                    m_buttonPalette->active()->backgroundHover,
-                                    m_d->activeStateChangeAnimationOpacity());
-        } else if (m_buttonPalette->active()->backgroundHover.isValid() && !m_buttonPalette->inactive()->backgroundHover.isValid()) {
-            return ColorTools::alphaMix(m_buttonPalette->active()->backgroundHover, m_d->activeStateChangeAnimationOpacity());
-        } else if (!m_buttonPalette->active()->backgroundHover.isValid() && m_buttonPalette->inactive()->backgroundHover.isValid()) {
-            return ColorTools::alphaMix(m_buttonPalette->inactive()->backgroundHover, (1.0 - m_d->activeStateChangeAnimationOpacity()));
-        } else {
-            return QColor();
-        }
+        return m_buttonPalette->activeStateRampColor(OverridableButtonColorState::BackgroundHover, m_d->activeStateChangeAnimationOpacity());
     } else {
         const DecorationButtonPaletteGroup *group = active ? m_buttonPalette->active() : m_buttonPalette->inactive();
         return group->backgroundHover;
@@ -481,16 +523,7 @@ QColor Button::backgroundHoverActiveStateAnimated(const bool active, const bool
 QColor Button::backgroundPressActiveStateAnimated(const bool active, const bool getNonAnimatedColor) const
 {
     if (!getNonAnimatedColor && m_d->activeStateChangeAnimation()->state() == QAbstractAnimation::Running) {
-        if (m_buttonPalette->active()->backgroundPress.isValid() && m_buttonPalette->inactive()->backgroundPress.isValid()) {
-            return KColorUtils::mix(m_buttonPalette->inactive()->backgroundPress,
-                                    m_buttonPalette->active()->backgroundPress,
-                                    m_d->activeStateChangeAnimationOpacity());
-        } else if (m_buttonPalette->active()->backgroundPress.isValid() && !m_buttonPalette->inactive()->backgroundPress.isValid()) {
-            return ColorTools::alphaMix(m_buttonPalette->active()->backgroundPress, m_d->activeStateChangeAnimationOpacity());
-        } else if (!m_buttonPalette->active()->backgroundPress.isValid() && m_buttonPalette->inactive()->backgroundPress.isValid()) {
-            return ColorTools::alphaMix(m_buttonPalette->inactive()->backgroundPress, (1.0 - m_d->activeStateChangeAnimationOpacity()));
-        } else
-            return QColor();
+        return m_buttonPalette->activeStateRampColor(OverridableButtonColorState::BackgroundPress, m_d->activeStateChangeAnimationOpacity());
     } else {
         const DecorationButtonPaletteGroup *group = active ? m_buttonPalette->active() : m_buttonPalette->inactive();
         return group->backgroundPress;
@@ -519,8 +552,13 @@ QColor Button::outlineColor(const bool getNonAnimatedColor) const
             return outlinePressActiveStateAnimated(active, getNonAnimatedColor);
         }
     } else if (m_animation->state() == QAbstractAnimation::Running && !getNonAnimatedColor) { // button hover animation
-        QColor outlineHover = outlineHoverActiveStateAnimated(active, getNonAnimatedColor);
+        if (m_d->activeStateChangeAnimation()->state() != QAbstractAnimation::Running) {
+            return m_buttonPalette->hoverRampColor(ButtonComponent::Outline, active, m_opacity);
+        }
+
+        // hover and active state change animations at once
         QColor outlineNormal = outlineNormalActiveStateAnimated(active, getNonAnimatedColor);
+        QColor outlineHover = outlineHoverActiveStateAnimated(active, getNonAnimatedColor);
         if (outlineNormal.isValid() && outlineHover.isValid()) {
             return KColorUtils::mix(outlineNormal, outlineHover, m_opacity);
         } else if (outlineHover.isValid()) {
@@ -537,17 +575,7 @@ QColor Button::outlineColor(const bool getNonAnimatedColor) const
 QColor Button::outlineNormalActiveStateAnimated(const bool active, const bool getNonAnimatedColor) const
 {
     if (!getNonAnimatedColor && m_d->activeStateChangeAnimation()->state() == QAbstractAnimation::Running) {
-        if (m_buttonPalette->active()->outlineNormal.isValid() && m_buttonPalette->inactive()->outlineNormal.isValid()) {
-            return KColorUtils::mix(m_buttonPalette->inactive()->outlineNormal,
-                                    m_buttonPalette->active()->outlineNormal,
-                                    m_d->activeStateChangeAnimationOpacity());
-        } else if (m_buttonPalette->active()->outlineNormal.isValid() && !m_buttonPalette->inactive()->outlineNormal.isValid()) {
-            return ColorTools::alphaMix(m_buttonPalette->active()->outlineNormal, m_d->activeStateChangeAnimationOpacity());
-        } else if (!m_buttonPalette->active()->outlineNormal.isValid() && m_buttonPalette->inactive()->outlineNormal.isValid()) {
-            return ColorTools::alphaMix(m_buttonPalette->inactive()->outlineNormal, (1.0 - m_d->activeStateChangeAnimationOpacity()));
-        } else {
-            return QColor();
-        }
+        return m_buttonPalette->activeStateRampColor(OverridableButtonColorState::OutlineNormal, m_d->activeStateChangeAnimationOpacity());
     } else {
         const DecorationButtonPaletteGroup *group = active ? m_buttonPalette->active() : m_buttonPalette->inactive();
         return group->outlineNormal;
@@ -557,17 +585,7 @@ QColor Button::outlineNormalActiveStateAnimated(const bool active, const bool ge
 QColor Button::outlineHoverActiveStateAnimated(const bool active, const bool getNonAnimatedColor) const
 {
     if (!getNonAnimatedColor && m_d->activeStateChangeAnimation()->state() == QAbstractAnimation::Running) {
-        if (m_buttonPalette->active()->outlineHover.isValid() && m_buttonPalette->inactive()->outlineHover.isValid()) {
-            return KColorUtils::mix(m_buttonPalette->inactive()->outlineHover,
-                                    m_buttonPalette->active()->outlineHover,
-                                    m_d->activeStateChangeAnimationOpacity());
-        } else if (m_buttonPalette->active()->outlineHover.isValid() && !m_buttonPalette->inactive()->outlineHover.isValid()) {
-            return ColorTools::alphaMix(m_buttonPalette->active()->outlineHover, m_d->activeStateChangeAnimationOpacity());
-        } else if (!m_buttonPalette->active()->outlineHover.isValid() && m_buttonPalette->inactive()->outlineHover.isValid()) {
-            return ColorTools::alphaMix(m_buttonPalette->inactive()->outlineHover, (1.0 - m_d->activeStateChangeAnimationOpacity()));
-        } else {
-            return QColor();
-        }
+        return m_buttonPalette->activeStateRampColor(OverridableButtonColorState::OutlineHover, m_d->activeStateChangeAnimationOpacity());
     } else {
         const DecorationButtonPaletteGroup *group = active ? m_buttonPalette->active() : m_buttonPalette->inactive();
         return group->outlineHover;
@@ -577,16 +595,7 @@ QColor Button::outlineHoverActiveStateAnimated(const bool active, const bool get
 QColor Button::outlinePressActiveStateAnimated(const bool active, const bool getNonAnimatedColor) const
 {
     if (!getNonAnimatedColor && m_d->activeStateChangeAnimation()->state() == QAbstractAnimation::Running) {
-        if (m_buttonPalette->active()->outlinePress.isValid() && m_buttonPalette->inactive()->outlinePress.isValid()) {
-            return KColorUtils::mix(m_buttonPalette->inactive()->outlinePress,
-                                    m_buttonPalette->active()->outlinePress,
-                                    m_d->activeStateChangeAnimationOpacity());
-        } else if (m_buttonPalette->active()->outlinePress.isValid() && !m_buttonPalette->inactive()->outlinePress.isValid()) {
-            return ColorTools::alphaMix(m_buttonPalette->active()->outlinePress, m_d->activeStateChangeAnimationOpacity());
-        } else if (!m_buttonPalette->active()->outlinePress.isValid() && m_buttonPalette->inactive()->outlinePress.isValid()) {
-            return ColorTools::alphaMix(m_buttonPalette->inactive()->outlinePress, (1.0 - m_d->activeStateChangeAnimationOpacity()));
-        } else
-            return QColor();
+        return m_buttonPalette->activeStateRampColor(OverridableButtonColorState::OutlinePress, m_d->activeStateChangeAnimationOpacity());
     } else {
         const DecorationButtonPaletteGroup *group = active ? m_buttonPalette->active() : m_buttonPalette->inactive();
         return group->outlinePress;
@@ -15,8 +15,6 @@
 #include <QHash>
 #include <QImage>
 
-class QVariantAnimation;
-
 namespace Breeze
 {
 
@@ -192,6 +190,9 @@ private:
     //* draw button icon
     void drawIcon(QPainter *) const;
 
+    //* blit the icon from the process-wide icon cache, rendering it into the cache first if necessary. Returns false if the icon cannot be cached
+    bool drawCachedIcon(QPainter *, const qreal iconWidth, const QPointF &deviceOffsetDecorationTopLeftToIconTopLeft, const bool forceEvenSquares) const;
+
     //*@name colors
     //@{
     QColor backgroundColor(const bool getNonAnimatedColor = false) const;
@@ -257,7 +258,7 @@ private:
     bool m_visibleBeforeSpacer = false;
 
     //* active state change animation
-    QVariantAnimation *m_animation;
+    ClockedAnimation *m_animation;
 
     //* icon offset (for rendering)
     mutable QPointF m_iconOffset;
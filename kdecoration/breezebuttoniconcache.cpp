@@ -0,0 +1,64 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Paul A McAuley <kde@paulmcauley.com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "breezebuttoniconcache.h"
+
+namespace Breeze
+{
+
+size_t qHash(const ButtonIconKey &key, size_t seed)
+{
+    return qHashMulti(seed,
+                      key.iconStyle,
+                      key.buttonType,
+                      key.checked,
+                      key.boldButtonIcons,
+                      key.forceEvenSquares,
+                      key.iconWidth,
+                      key.devicePixelRatio,
+                      key.deviceScale,
+                      key.penWidth,
+                      key.foregroundColor,
+                      key.phaseX,
+                      key.phaseY,
+                      key.snapOffsetX,
+                      key.snapOffsetY);
+}
+
+ButtonIconCache &ButtonIconCache::self()
+{
+    static ButtonIconCache s_self;
+    return s_self;
+}
+
+QImage ButtonIconCache::icon(const ButtonIconKey &key) const
+{
+    return m_icons.value(key);
+}
+
+void ButtonIconCache::insert(const ButtonIconKey &key, const QImage &image)
+{
+    // hover colours are cached, so bound the cache rather than track usage
+    if (m_icons.size() >= s_maxEntries) {
+        m_icons.clear();
+    }
+    m_icons.insert(key, image);
+}
+
+void ButtonIconCache::setSettingsGeneration(quint64 generation)
+{
+    if (generation != m_settingsGeneration) {
+        m_settingsGeneration = generation;
+        m_icons.clear();
+    }
+}
+
+void ButtonIconCache::clear()
+{
+    m_icons.clear();
+}
+
+}
@@ -0,0 +1,74 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Paul A McAuley <kde@paulmcauley.com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QImage>
+
+namespace Breeze
+{
+
+//* every input which affects a rasterised button icon
+struct ButtonIconKey {
+    int iconStyle = 0;
+    int buttonType = 0;
+    bool checked = false;
+    bool boldButtonIcons = false;
+    bool forceEvenSquares = false;
+    qreal iconWidth = 0;
+    qreal devicePixelRatio = 1;
+    //* scale of the painter's device transform at the icon
+    qreal deviceScale = 1;
+    qreal penWidth = 0;
+    quint64 foregroundColor = 0;
+    //* fractional device position of the icon origin, in 1/s_subpixelSteps pixels, which determines the anti-aliasing
+    int phaseX = 0;
+    int phaseY = 0;
+    //* fractional device offset from the decoration top-left, in 1/s_subpixelSteps pixels, which determines the pixel-snapping
+    int snapOffsetX = 0;
+    int snapOffsetY = 0;
+
+    bool operator==(const ButtonIconKey &other) const = default;
+
+    static constexpr int s_subpixelSteps = 1024;
+};
+
+size_t qHash(const ButtonIconKey &key, size_t seed = 0);
+
+/**
+ * @brief Process-wide cache of rasterised button icons, shared by all decorations, so that each icon variant is rendered once and then blitted.
+ *        The cache is emptied whenever the settings change, and when it grows beyond s_maxEntries.
+ */
+class ButtonIconCache
+{
+public:
+    //* singleton
+    static ButtonIconCache &self();
+
+    //* returns the cached icon image for the key, or a null image if not cached
+    QImage icon(const ButtonIconKey &key) const;
+
+    //* add an icon image to the cache
+    void insert(const ButtonIconKey &key, const QImage &image);
+
+    //* empty the cache if the settings generation differs from that of the cached icons
+    void setSettingsGeneration(quint64 generation);
+
+    //* remove all cached icons
+    void clear();
+
+private:
+    ButtonIconCache() = default;
+
+    QHash<ButtonIconKey, QImage> m_icons;
+
+    quint64 m_settingsGeneration = 0;
+
+    static constexpr int s_maxEntries = 256;
+};
+
+}
@@ -15,9 +15,11 @@
 
 #include "breezeboxshadowrenderer.h"
 #include "breezebutton.h"
+#include "breezebuttoniconcache.h"
 #include "breezesettingsprovider.h"
 #include "dbusupdatenotifier.h"
 #include "geometrytools.h"
+#include "shadowdiskcache.h"
 
 #include <KDecoration2/DecorationButtonGroup>
 #include <KDecoration2/DecorationShadow>
@@ -27,11 +29,9 @@
 #include <KPluginFactory>
 #include <KWindowSystem>
 
-#include <QDBusConnection>
-#include <QDBusMessage>
-#include <QDBusPendingCallWatcher>
-#include <QDBusPendingReply>
+#include <QDataStream>
 #include <QPainter>
+#include <QTextOption>
 #include <QTextStream>
 #include <QTimer>
 
@@ -116,6 +116,21 @@ inline CompositeShadowParams lookupShadowParams(int size)
         return s_shadowParams[3];
     }
 }
+
+//* serializes every input to the final decoration shadow texture, to key ShadowDiskCache
+QByteArray shadowDiskCacheKey(const Breeze::ShadowCacheKey &key)
+{
+    const CompositeShadowParams params = lookupShadowParams(key.shadowSize);
+
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream << QByteArrayLiteral("decoration") << key.shadowSize << key.shadowStrength << key.shadowColor << key.scaledCornerRadius << key.windowCornerRadius
+           << key.systemScaleFactor << key.hasNoBorders << key.roundBottomCornersWhenNoBorders << key.shaded << key.drawThinWindowOutline
+           << key.thinWindowOutlineColor << key.thinWindowOutlineThickness << params.offset << params.shadow1.offset << params.shadow1.radius
+           << params.shadow1.opacity << params.shadow2.offset << params.shadow2.radius << params.shadow2.opacity
+           << Breeze::Metrics::Decoration_Shadow_Overlap << KWindowSystem::isPlatformX11();
+    return data;
+}
 }
 
 namespace Breeze
@@ -128,29 +143,14 @@ using KDecoration2::ColorRole;
 
 static std::mutex g_setGlobalLookAndFeelOptionsMutex;
 
-// cached shadow values
 static int g_sDecoCount = 0;
-static int g_shadowSizeEnum = InternalSettings::EnumShadowSize::ShadowLarge;
-static int g_shadowStrength = 255;
-static QColor g_shadowColor = Qt::black;
-static qreal g_cornerRadius = 3;
-static qreal g_systemScaleFactor = 1;
-static bool g_hasNoBorders = true;
-static bool g_roundBottomCornersWhenNoBorders = false;
-static int g_thinWindowOutlineStyleActive = 0;
-static int g_thinWindowOutlineStyleInactive = 0;
-static QColor g_thinWindowOutlineColorActive = Qt::black;
-static QColor g_thinWindowOutlineColorInactive = Qt::black;
-static qreal g_thinWindowOutlineThickness = 1;
-static std::shared_ptr<KDecoration2::DecorationShadow> g_sShadow;
-static std::shared_ptr<KDecoration2::DecorationShadow> g_sShadowInactive;
 
 //________________________________________________________________
 Decoration::Decoration(QObject *parent, const QVariantList &args)
     : KDecoration2::Decoration(parent, args)
-    , m_animation(new QVariantAnimation(this))
-    , m_shadowAnimation(new QVariantAnimation(this))
-    , m_overrideOutlineFromButtonAnimation(new QVariantAnimation(this))
+    , m_animation(new ClockedAnimation(this))
+    , m_shadowAnimation(new ClockedAnimation(this))
+    , m_overrideOutlineFromButtonAnimation(new ClockedAnimation(this))
 
 {
 #if KLASSY_DECORATION_DEBUG_MODE
@@ -167,8 +167,9 @@ Decoration::~Decoration()
 {
     g_sDecoCount--;
     if (g_sDecoCount == 0) {
-        // last deco destroyed, clean up shadow
-        g_sShadow.reset();
+        // last deco destroyed, clean up shadows and button icons
+        ShadowCache::self().clear();
+        ButtonIconCache::self().clear();
     }
 }
 
@@ -287,23 +288,28 @@ void Decoration::init()
 {
     auto c = client();
 
+    // must be before connecting to the reconfigured signal below so that the settings snapshot is invalidated before this decoration reconfigures
+    SettingsProvider::self()->watchDecorationSettings(settings());
+
+    // the last known tablet mode state, so that the initial layout is already correct
+    m_tabletMode = SettingsProvider::self()->tabletMode();
+
     reconfigureMain(true);
     
     // active state change animation
-    // It is important start and end value are of the same type, hence 0.0 and not just 0
     m_animation->setStartValue(0.0);
     m_animation->setEndValue(1.0);
     // Linear to have the same easing as Breeze animations
     m_animation->setEasingCurve(QEasingCurve::Linear);
-    connect(m_animation, &QVariantAnimation::valueChanged, this, [this](const QVariant &value) {
-        setOpacity(value.toReal());
+    connect(m_animation, &ClockedAnimation::valueChanged, this, [this](qreal value) {
+        setOpacity(value);
     });
 
     m_shadowAnimation->setStartValue(0.0);
     m_shadowAnimation->setEndValue(1.0);
     m_shadowAnimation->setEasingCurve(QEasingCurve::OutCubic);
-    connect(m_shadowAnimation, &QVariantAnimation::valueChanged, this, [this](const QVariant &value) {
-        m_shadowOpacity = value.toReal();
+    connect(m_shadowAnimation, &ClockedAnimation::valueChanged, this, [this](qreal value) {
+        m_shadowOpacity = value;
         if (m_shadowAnimation->state() == QAbstractAnimation::Running)
             updateShadow();
     });
@@ -312,45 +318,17 @@ void Decoration::init()
     m_overrideOutlineFromButtonAnimation->setEndValue(1.0);
     m_overrideOutlineFromButtonAnimation->setEasingCurve(QEasingCurve::InOutQuad);
 
-    connect(m_overrideOutlineFromButtonAnimation, &QVariantAnimation::valueChanged, this, [this](const QVariant &value) {
-        m_overrideOutlineAnimationProgress = value.toReal();
+    connect(m_overrideOutlineFromButtonAnimation, &ClockedAnimation::valueChanged, this, [this](qreal value) {
+        m_overrideOutlineAnimationProgress = value;
         if (m_overrideOutlineFromButtonAnimation->state() == QAbstractAnimation::Running)
             updateShadow(false, true, true);
     });
 
-    // use DBus connection to update on Klassy configuration change
-    auto dbus = QDBusConnection::sessionBus();
-
-    dbus.connect(QString(),
-                 QStringLiteral("/KGlobalSettings"),
-                 QStringLiteral("org.kde.KGlobalSettings"),
-                 QStringLiteral("notifyChange"),
-                 this,
-                 SLOT(reconfigure()));
-
-    // Implement tablet mode DBus connection
-    dbus.connect(QStringLiteral("org.kde.KWin"),
-                 QStringLiteral("/org/kde/KWin"),
-                 QStringLiteral("org.kde.KWin.TabletModeManager"),
-                 QStringLiteral("tabletModeChanged"),
-                 QStringLiteral("b"),
-                 this,
-                 SLOT(onTabletModeChanged(bool)));
-
-    auto message = QDBusMessage::createMethodCall(QStringLiteral("org.kde.KWin"),
-                                                  QStringLiteral("/org/kde/KWin"),
-                                                  QStringLiteral("org.freedesktop.DBus.Properties"),
-                                                  QStringLiteral("Get"));
-    message.setArguments({QStringLiteral("org.kde.KWin.TabletModeManager"), QStringLiteral("tabletMode")});
-    auto call = new QDBusPendingCallWatcher(dbus.asyncCall(message), this);
-    connect(call, &QDBusPendingCallWatcher::finished, this, [this, call]() {
-        QDBusPendingReply<QVariant> reply = *call;
-        if (!reply.isError()) {
-            onTabletModeChanged(reply.value().toBool());
-        }
+    // KGlobalSettings notifyChange is relayed by SettingsProvider, which first reloads kdeglobals
+    connect(SettingsProvider::self(), &SettingsProvider::globalSettingsChanged, this, &Decoration::reconfigure);
 
-        call->deleteLater();
-    });
+    // tablet mode is watched once for all decorations by SettingsProvider
+    connect(SettingsProvider::self(), &SettingsProvider::tabletModeChanged, this, &Decoration::onTabletModeChanged);
 
     updateTitleBar();
     auto s = settings();
@@ -358,6 +336,7 @@ void Decoration::init()
     connect(s.get(), &KDecoration2::DecorationSettings::borderSizeChanged, this, &Decoration::updateBlur); // for the case when a border with transparency
 
     // a change in font might cause the borders to change
+    connect(s.get(), &KDecoration2::DecorationSettings::fontChanged, this, &Decoration::invalidateCaptionLayout);
     connect(s.get(), &KDecoration2::DecorationSettings::fontChanged, this, &Decoration::recalculateBorders);
     connect(s.get(), &KDecoration2::DecorationSettings::fontChanged, this, &Decoration::updateBlur); // for the case when a border with transparency
     connect(s.get(), &KDecoration2::DecorationSettings::spacingChanged, this, &Decoration::recalculateBorders);
@@ -380,7 +359,7 @@ void Decoration::init()
     connect(s.get(), &KDecoration2::DecorationSettings::decorationButtonsRightChanged, this, &Decoration::updateButtonsGeometryDelayed);
 
     // full reconfiguration
-    connect(s.get(), &KDecoration2::DecorationSettings::reconfigured, this, &Decoration::reconfigure);
+    connect(s.get(), &KDecoration2::DecorationSettings::reconfigured, this, &Decoration::reconfigureChangedSettings);
     connect(s.get(), &KDecoration2::DecorationSettings::reconfigured, this, &Decoration::updateButtonsGeometryDelayed);
 
     connect(c, &KDecoration2::DecoratedClient::adjacentScreenEdgesChanged, this, &Decoration::recalculateBorders);
@@ -389,7 +368,14 @@ void Decoration::init()
     connect(c, &KDecoration2::DecoratedClient::shadedChanged, this, &Decoration::recalculateBorders);
     connect(c, &KDecoration2::DecoratedClient::shadedChanged, this, &Decoration::updateShadowOnShadedChange);
     connect(c, &KDecoration2::DecoratedClient::captionChanged, this, [this]() {
+        // a window title exception may now match or no longer match
+        if (SettingsProvider::self()->hasTitleExceptions() && updateInternalSettings(true)) {
+            reconfigure();
+            return;
+        }
+
         // update the caption area
+        invalidateCaptionLayout();
         update(titleBar());
     });
 
@@ -397,13 +383,17 @@ void Decoration::init()
     connect(c, &KDecoration2::DecoratedClient::activeChanged, this, &Decoration::updateOpaque);
     connect(c, &KDecoration2::DecoratedClient::activeChanged, this, &Decoration::updateBlur);
     connect(c, &KDecoration2::DecoratedClient::adjacentScreenEdgesChanged, this, &Decoration::updateTitleBar);
-    connect(c, &KDecoration2::DecoratedClient::widthChanged, this, &Decoration::updateTitleBar);
-    connect(c, &KDecoration2::DecoratedClient::sizeChanged, this, &Decoration::updateBlur);
+    // resizing emits widthChanged and sizeChanged for each step, so coalesce the recalculations
+    connect(c, &KDecoration2::DecoratedClient::widthChanged, this, [this]() {
+        scheduleUpdates(PendingTitleBar | PendingButtonsGeometry);
+    });
+    connect(c, &KDecoration2::DecoratedClient::sizeChanged, this, [this]() {
+        scheduleUpdates(PendingBlur);
+    });
 
     connect(c, &KDecoration2::DecoratedClient::maximizedChanged, this, &Decoration::updateTitleBar);
     connect(c, &KDecoration2::DecoratedClient::maximizedChanged, this, &Decoration::updateOpaque);
 
-    connect(c, &KDecoration2::DecoratedClient::widthChanged, this, &Decoration::updateButtonsGeometry);
     connect(c, &KDecoration2::DecoratedClient::maximizedChanged, this, &Decoration::updateButtonsGeometry);
     connect(c, &KDecoration2::DecoratedClient::adjacentScreenEdgesChanged, this, &Decoration::updateButtonsGeometry);
     connect(c, &KDecoration2::DecoratedClient::shadedChanged, this, &Decoration::updateButtonsGeometry);
@@ -537,99 +527,153 @@ int Decoration::borderSize(bool bottom) const
 }
 
 //________________________________________________________________
-void Decoration::reconfigureMain(const bool noUpdateShadow)
+void Decoration::reconfigureMain(const bool noUpdateShadow, SettingsChanges changes)
 {
     auto c = client();
 
-    SettingsProvider::self()->reconfigure();
-    m_internalSettings = SettingsProvider::self()->internalSettings(this);
+    updateInternalSettings();
+
+    // include changes to the settings since last reconfigured
+    changes |= m_pendingSettingsChanges;
+    m_pendingSettingsChanges = SettingsChangeNone;
+
+    if (!changes) {
+        return;
+    }
 
     QPalette clientPalette = c->palette();
     updateDecorationColors(clientPalette);
 
-    s_kdeGlobalConfig->reparseConfiguration();
-    if (KWindowSystem::isPlatformX11()) {
-        // loads system ScaleFactor from ~/.config/kdeglobals
-        const KConfigGroup cgKScreen(s_kdeGlobalConfig, QStringLiteral("KScreen"));
-        m_systemScaleFactorX11 = cgKScreen.readEntry("ScaleFactor", 1.0f);
-    }
+    const KConfigGroup cg(s_kdeGlobalConfig, QStringLiteral("KDE"));
 
-    setScaledCornerRadius();
-    setScaledTitleBarTopBottomMargins();
-    setScaledTitleBarSideMargins();
+    setGlobalLookAndFeelOptions(cg.readEntry("LookAndFeelPackage"));
 
-    if (m_internalSettings->buttonShape() == InternalSettings::EnumButtonShape::ShapeFullHeightRectangle
-        || m_internalSettings->buttonShape() == InternalSettings::EnumButtonShape::ShapeFullHeightRoundedRectangle
-        || m_internalSettings->buttonShape() == InternalSettings::EnumButtonShape::ShapeIntegratedRoundedRectangle
-        || m_internalSettings->buttonShape() == InternalSettings::EnumButtonShape::ShapeIntegratedRoundedRectangleGrouped)
-        m_buttonBackgroundType = ButtonBackgroundType::FullHeight;
-    else
-        m_buttonBackgroundType = ButtonBackgroundType::Small;
+    if (changes & (SettingsChangeGeometry | SettingsChangeShadow | SettingsChangeButtonIcons)) {
+        if (KWindowSystem::isPlatformX11()) {
+            // loads system ScaleFactor from ~/.config/kdeglobals
+            const KConfigGroup cgKScreen(s_kdeGlobalConfig, QStringLiteral("KScreen"));
+            m_systemScaleFactorX11 = cgKScreen.readEntry("ScaleFactor", 1.0f);
+        }
 
-    calculateIconSizes();
+        setScaledCornerRadius();
+    }
 
-    const KConfigGroup cg(s_kdeGlobalConfig, QStringLiteral("KDE"));
+    if (changes & (SettingsChangeGeometry | SettingsChangeButtonIcons)) {
+        setScaledTitleBarTopBottomMargins();
+        setScaledTitleBarSideMargins();
 
-    setGlobalLookAndFeelOptions(cg.readEntry("LookAndFeelPackage"));
+        if (m_internalSettings->buttonShape() == InternalSettings::EnumButtonShape::ShapeFullHeightRectangle
+            || m_internalSettings->buttonShape() == InternalSettings::EnumButtonShape::ShapeFullHeightRoundedRectangle
+            || m_internalSettings->buttonShape() == InternalSettings::EnumButtonShape::ShapeIntegratedRoundedRectangle
+            || m_internalSettings->buttonShape() == InternalSettings::EnumButtonShape::ShapeIntegratedRoundedRectangleGrouped)
+            m_buttonBackgroundType = ButtonBackgroundType::FullHeight;
+        else
+            m_buttonBackgroundType = ButtonBackgroundType::Small;
+
+        calculateIconSizes();
+    }
 
-    m_colorSchemeHasHeaderColor = KColorScheme::isColorSetSupported(s_kdeGlobalConfig, KColorScheme::Header);
+    if (changes & SettingsChangeColors) {
+        m_colorSchemeHasHeaderColor = KColorScheme::isColorSetSupported(s_kdeGlobalConfig, KColorScheme::Header);
 
-    // m_toolsAreaWillBeDrawn = ( m_colorSchemeHasHeaderColor && ( settings()->borderSize() == KDecoration2::BorderSize::None || settings()->borderSize() ==
-    // KDecoration2::BorderSize::NoSides ) );
-    m_toolsAreaWillBeDrawn = (m_colorSchemeHasHeaderColor);
+        // m_toolsAreaWillBeDrawn = ( m_colorSchemeHasHeaderColor && ( settings()->borderSize() == KDecoration2::BorderSize::None || settings()->borderSize()
+        // == KDecoration2::BorderSize::NoSides ) );
+        m_toolsAreaWillBeDrawn = (m_colorSchemeHasHeaderColor);
+    }
 
     // animation
-    if (m_internalSettings->animationsEnabled()) {
-        qreal animationsDurationFactorRelativeSystem = 1;
-        if (m_internalSettings->animationsSpeedRelativeSystem() < 0)
-            animationsDurationFactorRelativeSystem = (-m_internalSettings->animationsSpeedRelativeSystem() + 2) / 2.0f;
-        else if (m_internalSettings->animationsSpeedRelativeSystem() > 0)
-            animationsDurationFactorRelativeSystem = 1 / ((m_internalSettings->animationsSpeedRelativeSystem() + 2) / 2.0f);
-        m_animation->setDuration(cg.readEntry("AnimationDurationFactor", 1.0f) * 150.0f * animationsDurationFactorRelativeSystem);
-        m_shadowAnimation->setDuration(m_animation->duration());
-        m_overrideOutlineFromButtonAnimation->setDuration(m_animation->duration());
-    } else {
-        m_animation->setDuration(0);
-        m_shadowAnimation->setDuration(0);
-        m_overrideOutlineFromButtonAnimation->setDuration(0);
+    if (changes & SettingsChangeAnimations) {
+        if (m_internalSettings->animationsEnabled()) {
+            qreal animationsDurationFactorRelativeSystem = 1;
+            if (m_internalSettings->animationsSpeedRelativeSystem() < 0)
+                animationsDurationFactorRelativeSystem = (-m_internalSettings->animationsSpeedRelativeSystem() + 2) / 2.0f;
+            else if (m_internalSettings->animationsSpeedRelativeSystem() > 0)
+                animationsDurationFactorRelativeSystem = 1 / ((m_internalSettings->animationsSpeedRelativeSystem() + 2) / 2.0f);
+            m_animation->setDuration(cg.readEntry("AnimationDurationFactor", 1.0f) * 150.0f * animationsDurationFactorRelativeSystem);
+            m_shadowAnimation->setDuration(m_animation->duration());
+            m_overrideOutlineFromButtonAnimation->setDuration(m_animation->duration());
+        } else {
+            m_animation->setDuration(0);
+            m_shadowAnimation->setDuration(0);
+            m_overrideOutlineFromButtonAnimation->setDuration(0);
+        }
     }
 
-    // borders
-    recalculateBorders();
+    if (changes & (SettingsChangeGeometry | SettingsChangeButtonIcons)) {
+        // borders
+        recalculateBorders();
+    }
 
-    updateOpaque();
-    updateBlur();
+    if (changes & (SettingsChangeGeometry | SettingsChangeColors)) {
+        updateOpaque();
+        updateBlur();
+    }
 
     // shadow
-    if (!noUpdateShadow)
+    if (!noUpdateShadow && (changes & (SettingsChangeShadow | SettingsChangeColors | SettingsChangeGeometry)))
         this->updateShadow();
 
-    Q_EMIT reconfigured();
+    // buttons
+    if (changes & ~SettingsChanges(SettingsChangeShadow))
+        Q_EMIT reconfigured();
 }
 
 void Decoration::updateDecorationColors(const QPalette &clientPalette, QByteArray uuid)
 {
-    QPalette systemPalette = KColorScheme::createApplicationPalette(s_kdeGlobalConfig);
-    bool clientSpecificPalette = false;
-    if (clientPalette != systemPalette) { // Some applications can set a Window Colour Scheme, meaning the client palette and system palette differ
-        clientSpecificPalette = true;
-    }
+    // the system palette is built once per kdeglobals change for all decorations, and palettes are compared by hash rather than colour by colour
+    SettingsProvider *settingsProvider = SettingsProvider::self();
+    const size_t clientPaletteHash = settingsProvider->paletteHash(clientPalette);
+    // Some applications can set a Window Colour Scheme, meaning the client palette and system palette differ
+    const bool clientSpecificPalette = clientPaletteHash != settingsProvider->systemPaletteHash();
 
     // The preset exception may modify the decoration colours by having a different translucentButtonBackgroundsOpacity, so in this case we don't want to
     // cache the decoration colours as it may corrupt the colours for normal non-exception decoration windows
-    bool noCache = m_internalSettings->property("noCacheException").toBool() || clientSpecificPalette;
+    const bool noCache = m_internalSettings->property("noCacheException").toBool();
+
+    auto c = client();
+    const QColor activeTitleBarBase = c->color(ColorGroup::Active, ColorRole::TitleBar);
+    const QColor inactiveTitlebarBase = c->color(ColorGroup::Inactive, ColorRole::TitleBar);
+    const QColor activeTitleBarText = c->color(ColorGroup::Active, ColorRole::Foreground);
+    const QColor inactiveTitleBarText = c->color(ColorGroup::Inactive, ColorRole::Foreground);
+
+    if (clientSpecificPalette && !noCache) {
+        // windows using the same application colour scheme share one set of colours, generated once per settings generation
+        const ClientPaletteColorsKey key{clientPaletteHash,
+                                         m_settingsGeneration,
+                                         m_internalSettings.data(),
+                                         activeTitleBarText.rgba(),
+                                         activeTitleBarBase.rgba(),
+                                         inactiveTitleBarText.rgba(),
+                                         inactiveTitlebarBase.rgba()};
+        m_decorationColors = settingsProvider->clientPaletteColors(key);
+        m_decorationColorsShared = true;
+
+        if (!m_decorationColors->areColorsGenerated()) {
+            m_decorationColors->generateDecorationAndButtonColors(clientPalette,
+                                                                  m_internalSettings,
+                                                                  activeTitleBarText,
+                                                                  activeTitleBarBase,
+                                                                  inactiveTitleBarText,
+                                                                  inactiveTitlebarBase,
+                                                                  uuid);
+        }
+        return;
+    }
 
     if (noCache) {
-        if (!m_decorationColors || m_decorationColors->isCachedPalette()) {
-            m_decorationColors = std::make_unique<DecorationColors>(false);
+        // a shared client palette colour set must not be regenerated with this decoration's settings
+        if (!m_decorationColors || m_decorationColors->isCachedPalette() || m_decorationColorsShared) {
+            m_decorationColors = std::make_shared<DecorationColors>(false);
+            m_decorationColorsShared = false;
         }
     } else {
         if (!m_decorationColors || !m_decorationColors->isCachedPalette()) {
-            m_decorationColors = std::make_unique<DecorationColors>(true);
+            m_decorationColors = std::make_shared<DecorationColors>(true);
+            m_decorationColorsShared = false;
         }
     }
 
-    QPalette palette = clientSpecificPalette ? clientPalette : systemPalette;
+    const QPalette &palette = clientSpecificPalette ? clientPalette : settingsProvider->systemPalette();
     bool generateColors = false;
 
     if (!m_decorationColors->areColorsGenerated()) {
@@ -643,19 +687,12 @@ void Decoration::updateDecorationColors(const QPalette &clientPalette, QByteArra
 
         // TODO: palette may not be a reliable indicator of the entire colour scheme - get an update to KDecoration2::DecoratedClient to read QString
         // m_colorScheme instead
-        if (!generateColors && palette != *m_decorationColors->basePalette()) {
+        if (!generateColors && clientPaletteHash != settingsProvider->paletteHash(*m_decorationColors->basePalette())) {
             generateColors = true;
         }
     }
 
     if (generateColors) {
-        auto c = client();
-
-        QColor activeTitleBarBase = c->color(ColorGroup::Active, ColorRole::TitleBar);
-        QColor inactiveTitlebarBase = c->color(ColorGroup::Inactive, ColorRole::TitleBar);
-        QColor activeTitleBarText = c->color(ColorGroup::Active, ColorRole::Foreground);
-        QColor inactiveTitleBarText = c->color(ColorGroup::Inactive, ColorRole::Foreground);
-
         m_decorationColors->generateDecorationAndButtonColors(palette,
                                                               m_internalSettings,
                                                               activeTitleBarText,
@@ -668,9 +705,7 @@ void Decoration::updateDecorationColors(const QPalette &clientPalette, QByteArra
 
 void Decoration::generateDecorationColorsOnClientPaletteUpdate(const QPalette &clientPalette)
 {
-    SettingsProvider::self()->reconfigure();
-    m_internalSettings = SettingsProvider::self()->internalSettings(this);
-    s_kdeGlobalConfig->reparseConfiguration();
+    updateInternalSettings();
 
     updateDecorationColors(clientPalette);
     reconfigure();
@@ -681,9 +716,7 @@ void Decoration::generateDecorationColorsOnDecorationColorSettingsUpdate(QByteAr
     auto c = client();
     QPalette clientPalette = c->palette();
 
-    SettingsProvider::self()->reconfigure();
-    m_internalSettings = SettingsProvider::self()->internalSettings(this);
-    s_kdeGlobalConfig->reparseConfiguration();
+    updateInternalSettings();
 
     updateDecorationColors(clientPalette, uuid);
 }
@@ -693,14 +726,40 @@ void Decoration::generateDecorationColorsOnSystemColorSettingsUpdate(QByteArray
     auto c = client();
     QPalette clientPalette = c->palette();
 
-    SettingsProvider::self()->reconfigure();
-    m_internalSettings = SettingsProvider::self()->internalSettings(this);
-    s_kdeGlobalConfig->reparseConfiguration();
+    updateInternalSettings();
 
     updateDecorationColors(clientPalette, uuid);
     reconfigure();
 }
 
+bool Decoration::updateInternalSettings(const bool rematchExceptions)
+{
+    // the settings snapshot (and kdeglobals) is reloaded at most once per change notification, however many decorations respond to it
+    const quint64 generation = SettingsProvider::self()->generation();
+    const bool newGeneration = !m_internalSettings || generation != m_settingsGeneration;
+    if (!newGeneration && !rematchExceptions) {
+        return false;
+    }
+
+    const InternalSettingsPtr internalSettings = SettingsProvider::self()->internalSettings(this);
+    if (newGeneration) {
+        // snapshots skipped by this decoration could have changed anything
+        m_pendingSettingsChanges |= (generation == m_settingsGeneration + 1) ? SettingsProvider::self()->changes() : SettingsChanges(SettingsChangeAll);
+    } else if (internalSettings != m_internalSettings) {
+        // a different exception now matches, which could differ from the previous one in anything
+        m_pendingSettingsChanges |= SettingsChangeAll;
+    } else {
+        return false;
+    }
+
+    m_settingsGeneration = generation;
+    m_internalSettings = internalSettings;
+
+    // cached icons were rendered with the previous settings
+    ButtonIconCache::self().setSettingsGeneration(generation);
+    return true;
+}
+
 void Decoration::setGlobalLookAndFeelOptions(QString lookAndFeelPackageName)
 {
     if (lookAndFeelPackageName == m_internalSettings->lookAndFeelSet()) {
@@ -805,16 +864,110 @@ void Decoration::createButtons()
 //________________________________________________________________
 void Decoration::updateButtonsGeometryDelayed()
 {
-    QTimer::singleShot(0, this, &Decoration::updateButtonsGeometry);
+    // settings and button list changes, so always rebuild the layout rather than rely on the key (recreated buttons may reuse addresses)
+    m_buttonsLayoutKey = ButtonsLayoutKey();
+    scheduleUpdates(PendingButtonsGeometry);
+}
+
+//________________________________________________________________
+void Decoration::scheduleUpdates(PendingUpdates updates)
+{
+    const bool scheduled = m_pendingUpdates;
+    m_pendingUpdates |= updates;
+    if (!scheduled) {
+        QTimer::singleShot(0, this, &Decoration::flushPendingUpdates);
+    }
+}
+
+//________________________________________________________________
+void Decoration::flushPendingUpdates()
+{
+    const PendingUpdates updates = m_pendingUpdates;
+    m_pendingUpdates = PendingUpdates();
+
+    // in dependency order: the buttons are laid out within the titlebar, and the blur follows the shapes
+    if (updates & PendingTitleBar) {
+        updateTitleBar();
+    }
+    if (updates & PendingButtonsGeometry) {
+        updateButtonsGeometry();
+    }
+    if (updates & PendingBlur) {
+        updateBlur();
+    }
 }
 
 //________________________________________________________________
 void Decoration::updateButtonsGeometry()
 {
-    const auto s = settings();
+    positionButtons();
+    update();
+}
 
+//________________________________________________________________
+void Decoration::positionButtons()
+{
     setScaledTitleBarSideMargins();
 
+    // the layout only depends on the window width through the right group's position, so a resize just moves that group
+    const ButtonsLayoutKey key = buttonsLayoutKey();
+    if (key != m_buttonsLayoutKey) {
+        m_buttonsLayoutKey = key;
+        layoutButtons();
+    }
+
+    if (m_rightButtonsLaidOut) {
+        m_rightButtons->setPos(QPointF(size().width() - m_rightButtons->geometry().width() - m_rightButtonsInset, m_rightButtonsVerticalPadding));
+    }
+}
+
+//________________________________________________________________
+Decoration::ButtonsLayoutKey Decoration::buttonsLayoutKey() const
+{
+    const auto s = settings();
+    const auto c = client();
+
+    ButtonsLayoutKey key;
+    key.internalSettings = m_internalSettings.data();
+    key.settingsGeneration = m_settingsGeneration;
+    key.smallSpacing = s->smallSpacing();
+    key.borderTop = borderTop();
+    key.borderLeft = borderLeft();
+    key.borderRight = borderRight();
+    key.captionHeight = captionHeight();
+    key.titleBarSeparatorHeight = titleBarSeparatorHeight();
+    key.titleBarTopMargin = m_scaledTitleBarTopMargin;
+    key.titleBarLeftMargin = m_scaledTitleBarLeftMargin;
+    key.titleBarRightMargin = m_scaledTitleBarRightMargin;
+    key.integratedRoundedRectangleBottomPadding = m_scaledIntegratedRoundedRectangleBottomPadding;
+    key.buttonBackgroundType = m_buttonBackgroundType;
+    key.smallButtonPaddedSize = m_smallButtonPaddedSize;
+    key.iconSize = m_iconSize;
+    key.smallButtonBackgroundSize = m_smallButtonBackgroundSize;
+    key.systemScaleFactorX11 = m_systemScaleFactorX11;
+    key.maximized = c->isMaximized();
+    key.topEdge = isTopEdge();
+    key.leftEdge = isLeftEdge();
+    key.rightEdge = isRightEdge();
+
+    for (const auto group : {m_leftButtons, m_rightButtons}) {
+        for (const auto &button : group->buttons()) {
+            key.buttons.append(button);
+            key.buttonsVisible.append(button->isVisible() && button->isEnabled());
+        }
+        // group separator
+        key.buttons.append(nullptr);
+    }
+    return key;
+}
+
+//________________________________________________________________
+void Decoration::layoutButtons()
+{
+    const auto s = settings();
+
+    m_rightButtonsLaidOut = false;
+
     // adjust button position
     qreal bHeightNormal;
     qreal bWidthLeft = 0;
@@ -1138,30 +1291,39 @@ void Decoration::updateButtonsGeometry()
         if (isRightEdge()) {
             lastButton->setGeometry(QRectF(QPoint(0, 0), QSizeF(lastButton->geometry().width() + hPadding, lastButton->geometry().height())));
 
-            m_rightButtons->setPos(QPointF(size().width() - m_rightButtons->geometry().width(), vPadding));
-
+            m_rightButtonsInset = 0;
         } else {
-            m_rightButtons->setPos(QPointF(size().width() - m_rightButtons->geometry().width() - hPadding - borderRight(), vPadding));
+            m_rightButtonsInset = hPadding + borderRight();
         }
+        m_rightButtonsVerticalPadding = vPadding;
+        m_rightButtonsLaidOut = true;
     }
-
-    update();
 }
 
 //________________________________________________________________
 void Decoration::paint(QPainter *painter, const QRect &repaintRegion)
 {
+    // the frame must be painted with the current button positions (the titlebar rect is recalculated from the size below). The titlebar and blur
+    // regions are left to the scheduled flush, so that KWin state is not changed, nor another repaint requested, during paint
+    if (m_pendingUpdates & PendingButtonsGeometry) {
+        m_pendingUpdates &= ~PendingUpdates(PendingButtonsGeometry);
+        positionButtons();
+    }
+
     m_painting = true;
 
-    // TODO: optimize based on repaintRegion
     auto c = client();
     auto s = settings();
 
     calculateWindowAndTitleBarShapes();
 
+    // only rasterise inside the damaged region -- areas outside repaintRegion are never touched
+    painter->save();
+    painter->setClipRect(repaintRegion, Qt::IntersectClip);
+
     // paint background
-    if (!c->isShaded()) {
-        painter->fillRect(rect(), Qt::transparent);
+    if (!c->isShaded() && borderRegion().intersects(repaintRegion)) {
+        painter->fillRect(rect().intersected(repaintRegion), Qt::transparent);
         painter->save();
         painter->setRenderHint(QPainter::Antialiasing);
         painter->setPen(Qt::NoPen);
@@ -1174,13 +1336,9 @@ void Decoration::paint(QPainter *painter, const QRect &repaintRegion)
 
         painter->setBrush(windowBorderColor);
 
-        QPainterPath clipRect;
-        // use clipRect for clipping away the top part
         if (!hideTitleBar()) {
-            clipRect.addRect(0, borderTop(), size().width(), size().height() - borderTop());
-            // clip off the titlebar and draw bottom part
-            QPainterPath windowPathMinusTitleBar = m_windowPath.intersected(clipRect);
-            painter->drawPath(windowPathMinusTitleBar);
+            // draw the part below the titlebar
+            painter->drawPath(m_windowPathMinusTitleBar);
         } else {
             painter->drawPath(m_windowPath);
         }
@@ -1192,7 +1350,8 @@ void Decoration::paint(QPainter *painter, const QRect &repaintRegion)
         paintTitleBar(painter, repaintRegion);
     }
 
-    if (hasBorders() && !s->isAlphaChannelSupported()) {
+    // the non-alpha outline is a 1px rectangle around the edge, so only draw it if the damaged region reaches the edge
+    if (hasBorders() && !s->isAlphaChannelSupported() && !rect().adjusted(1, 1, -1, -1).contains(repaintRegion)) {
         painter->save();
         painter->setRenderHint(QPainter::Antialiasing, false);
         painter->setBrush(Qt::NoBrush);
@@ -1202,32 +1361,57 @@ void Decoration::paint(QPainter *painter, const QRect &repaintRegion)
         painter->restore();
     }
 
+    painter->restore();
+
     m_painting = false;
 }
 
-void Decoration::calculateWindowAndTitleBarShapes(const bool windowShapeOnly)
+//________________________________________________________________
+QRegion Decoration::borderRegion() const
+{
+    // the decoration area outside the client, excluding the titlebar which is painted separately by paintTitleBar()
+    const QRect clientRect = rect().adjusted(borderLeft(), borderTop(), -borderRight(), -borderBottom());
+    const QRect bordersRect = hideTitleBar() ? rect() : rect().adjusted(0, borderTop(), 0, 0);
+    return QRegion(bordersRect).subtracted(clientRect);
+}
+
+void Decoration::calculateWindowAndTitleBarShapes()
 {
     auto c = client();
     auto s = settings();
 
-    if (!windowShapeOnly || c->isShaded()) {
-        // set titleBar geometry and path
-        m_titleRect = QRect(QPoint(0, 0), QSize(size().width(), borderTop()));
-        m_titleBarPath.clear(); // clear the path for subsequent calls to this function
-        if (isMaximized() || !s->isAlphaChannelSupported()) {
-            m_titleBarPath.addRect(m_titleRect);
-        } else if (c->isShaded()) {
-            m_titleBarPath.addRoundedRect(m_titleRect, m_scaledCornerRadius, m_scaledCornerRadius);
-        } else {
-            m_titleBarPath = GeometryTools::roundedPath(m_titleRect, CornersTop, m_scaledCornerRadius);
-        }
+    WindowShapesKey key;
+    key.size = size();
+    key.titleBarHeight = borderTop();
+    key.cornerRadius = m_scaledCornerRadius;
+    key.maximized = isMaximized();
+    key.shaded = c->isShaded();
+    key.alphaChannelSupported = s->isAlphaChannelSupported();
+    key.squareBottomCorners = hasNoBorders() && !m_internalSettings->roundBottomCornersWhenNoBorders();
+
+    // the paths are unchanged, so save rebuilding them and the costly intersection below
+    if (key == m_windowShapesKey) {
+        return;
+    }
+    m_windowShapesKey = key;
+
+    // set titleBar geometry and path
+    m_titleRect = QRect(QPoint(0, 0), QSize(size().width(), borderTop()));
+    m_titleBarPath.clear(); // clear the path for subsequent calls to this function
+    if (key.maximized || !key.alphaChannelSupported) {
+        m_titleBarPath.addRect(m_titleRect);
+    } else if (key.shaded) {
+        m_titleBarPath.addRoundedRect(m_titleRect, m_scaledCornerRadius, m_scaledCornerRadius);
+    } else {
+        m_titleBarPath = GeometryTools::roundedPath(m_titleRect, CornersTop, m_scaledCornerRadius);
     }
 
     // set windowPath
     m_windowPath.clear(); // clear the path for subsequent calls to this function
-    if (!c->isShaded()) {
-        if (s->isAlphaChannelSupported() && !isMaximized()) {
-            if (hasNoBorders() && !m_internalSettings->roundBottomCornersWhenNoBorders()) { // round at top, square at bottom
+    m_windowPathMinusTitleBar.clear();
+    if (!key.shaded) {
+        if (key.alphaChannelSupported && !key.maximized) {
+            if (key.squareBottomCorners) { // round at top, square at bottom
                 m_windowPath = GeometryTools::roundedPath(rect(), CornersTop, m_scaledCornerRadius);
             } else {
                 m_windowPath.addRoundedRect(rect(), m_scaledCornerRadius, m_scaledCornerRadius);
@@ -1235,6 +1419,11 @@ void Decoration::calculateWindowAndTitleBarShapes(const bool windowShapeOnly)
         } else // maximized / no alpha
             m_windowPath.addRect(rect());
 
+        // clip off the titlebar to give the bottom part
+        QPainterPath clipRect;
+        clipRect.addRect(0, borderTop(), size().width(), size().height() - borderTop());
+        m_windowPathMinusTitleBar = m_windowPath.intersected(clipRect);
+
     } else { // shaded
         m_windowPath = m_titleBarPath;
     }
@@ -1243,19 +1432,139 @@ void Decoration::calculateWindowAndTitleBarShapes(const bool windowShapeOnly)
 //________________________________________________________________
 void Decoration::paintTitleBar(QPainter *painter, const QRect &repaintRegion)
 {
-    const auto c = client();
-
     if (!m_titleRect.intersects(repaintRegion)) {
         return;
     }
 
+    const TitleBarBackgroundKey key = titleBarBackgroundKey(painter);
+
+    // only the static active and inactive backgrounds are cached; animation frames are painted directly, as is the first frame at a new size so that
+    // an interactive resize does not render a pixmap per step. The cached pixmap can only be blitted pixel-for-pixel through a translating painter
+    const bool newGeometry = key.size != m_titleBarBackgroundSize || key.devicePixelRatio != m_titleBarBackgroundDevicePixelRatio;
+    if (newGeometry) {
+        // a resize or scale change makes every cached background stale
+        m_titleBarBackgroundCache.clear();
+        m_titleBarBackgroundSize = key.size;
+        m_titleBarBackgroundDevicePixelRatio = key.devicePixelRatio;
+    }
+
+    if (m_animation->state() == QAbstractAnimation::Running || newGeometry || painter->worldTransform().type() > QTransform::TxTranslate) {
+        renderTitleBarBackground(painter, key);
+    } else {
+        QPixmap pixmap = m_titleBarBackgroundCache.value(key);
+        if (pixmap.isNull()) {
+            pixmap = QPixmap((QSizeF(key.size) * key.devicePixelRatio).toSize());
+            pixmap.setDevicePixelRatio(key.devicePixelRatio);
+            pixmap.fill(Qt::transparent);
+
+            QPainter pixmapPainter(&pixmap);
+            pixmapPainter.setRenderHints(painter->renderHints());
+            renderTitleBarBackground(&pixmapPainter, key);
+            pixmapPainter.end();
+
+            // at most the active and inactive backgrounds
+            if (m_titleBarBackgroundCache.size() >= 2) {
+                m_titleBarBackgroundCache.clear();
+            }
+            m_titleBarBackgroundCache.insert(key, pixmap);
+        }
+        painter->drawPixmap(m_titleRect.topLeft(), pixmap);
+    }
+
+    paintCaption(painter, repaintRegion);
+
+    // draw button groups which intersect the damaged region (each button further checks its own geometry)
+    if (m_leftButtons->geometry().toAlignedRect().intersects(repaintRegion)) {
+        m_leftButtons->paint(painter, repaintRegion);
+    }
+    if (m_rightButtons->geometry().toAlignedRect().intersects(repaintRegion)) {
+        m_rightButtons->paint(painter, repaintRegion);
+    }
+}
+
+//________________________________________________________________
+void Decoration::paintCaption(QPainter *painter, const QRect &repaintRegion)
+{
+    const auto cR = captionRect();
+    if (!cR.first.intersects(repaintRegion)) {
+        return;
+    }
+
+    const auto c = client();
+    const QFont font = settings()->font();
+
+    if (m_captionLayout.caption != c->caption() || m_captionLayout.font != font || m_captionLayout.rect != cR.first
+        || m_captionLayout.alignment != cR.second) {
+        const QFontMetrics fontMetrics(font);
+        const QString caption = fontMetrics.elidedText(c->caption(), Qt::ElideMiddle, cR.first.width());
+
+        m_captionLayout.caption = c->caption();
+        m_captionLayout.font = font;
+        m_captionLayout.rect = cR.first;
+        m_captionLayout.alignment = cR.second;
+        m_captionLayout.text = QStaticText(caption);
+        m_captionLayout.text.setTextFormat(Qt::PlainText);
+
+        // Qt aligns the text horizontally within the caption rect width; QStaticText has no vertical alignment, so centre it with fractional metrics
+        QTextOption textOption(cR.second & Qt::AlignHorizontal_Mask);
+        textOption.setWrapMode(QTextOption::NoWrap);
+        m_captionLayout.text.setTextOption(textOption);
+        m_captionLayout.text.setTextWidth(cR.first.width());
+        m_captionLayout.text.prepare(QTransform(), font);
+
+        const QFontMetricsF fontMetricsF(font);
+        m_captionLayout.position = QPointF(cR.first.left(), cR.first.top() + (cR.first.height() - fontMetricsF.height()) / 2);
+    }
+
+    painter->setFont(font);
+    painter->setPen(fontColor());
+    painter->drawStaticText(m_captionLayout.position, m_captionLayout.text);
+}
+
+//________________________________________________________________
+TitleBarBackgroundKey Decoration::titleBarBackgroundKey(QPainter *painter) const
+{
+    const auto c = client();
+
+    TitleBarBackgroundKey key;
+    key.size = m_titleRect.size();
+    key.devicePixelRatio = painter->device()->devicePixelRatioF();
+    key.active = c->isActive();
+    key.gradient = key.active && m_internalSettings->drawBackgroundGradient();
+    key.cornerRadius = m_scaledCornerRadius;
+    if (isMaximized() || !settings()->isAlphaChannelSupported()) {
+        key.shape = 0;
+    } else if (c->isShaded()) {
+        key.shape = 2;
+    } else {
+        key.shape = 1;
+    }
+    key.color = titleBarColor().rgba();
+
+    const QColor titleBarSeparatorColor(this->titleBarSeparatorColor());
+    const int separatorHeight = titleBarSeparatorHeight();
+    if (separatorHeight && titleBarSeparatorColor.isValid()) {
+        key.separatorColor = titleBarSeparatorColor.rgba();
+        key.separatorHeight = separatorHeight;
+        key.separatorPenWidth = qRound(devicePixelRatio(painter));
+        if (m_internalSettings->useTitleBarColorForAllBorders()) {
+            key.separatorInsetLeft = borderLeft();
+            key.separatorInsetRight = borderRight();
+        }
+    }
+    return key;
+}
+
+//________________________________________________________________
+void Decoration::renderTitleBarBackground(QPainter *painter, const TitleBarBackgroundKey &key) const
+{
     painter->save();
     painter->setPen(Qt::NoPen);
 
-    QColor titleBarColor(this->titleBarColor());
+    const QColor titleBarColor = QColor::fromRgba(key.color);
 
     // render a linear gradient on title area
-    if (c->isActive() && m_internalSettings->drawBackgroundGradient()) {
+    if (key.gradient) {
         QLinearGradient gradient(0, 0, 0, m_titleRect.height());
         gradient.setColorAt(0.0, titleBarColor.lighter(120));
         gradient.setColorAt(0.8, titleBarColor);
@@ -1265,45 +1574,26 @@ void Decoration::paintTitleBar(QPainter *painter, const QRect &repaintRegion)
         painter->setBrush(titleBarColor);
     }
 
-    auto s = settings();
-
     painter->drawPath(m_titleBarPath);
 
     // draw titlebar separator
-    const QColor titleBarSeparatorColor(this->titleBarSeparatorColor());
-    int separatorHeight;
-    if ((separatorHeight = titleBarSeparatorHeight()) && titleBarSeparatorColor.isValid()) {
+    if (key.separatorHeight) {
         // outline
         painter->setRenderHint(QPainter::Antialiasing);
         painter->setBrush(Qt::NoBrush);
-        QPen p(titleBarSeparatorColor);
-        p.setWidthF(qRound(devicePixelRatio(painter)));
+        QPen p(QColor::fromRgba(key.separatorColor));
+        p.setWidthF(key.separatorPenWidth);
         p.setCosmetic(true);
         p.setCapStyle(Qt::FlatCap);
         painter->setPen(p);
 
         QRectF titleRectF(m_titleRect); // use a QRectF because QRects have quirks when getting their corner positions
-        qreal separatorYCoOrd = qreal(titleRectF.bottom()) - qreal(separatorHeight) / 2;
-        if (m_internalSettings->useTitleBarColorForAllBorders()) {
-            painter->drawLine(QPointF(titleRectF.bottomLeft().x() + borderLeft(), separatorYCoOrd),
-                              QPointF(titleRectF.bottomRight().x() - borderRight(), separatorYCoOrd));
-        } else {
-            painter->drawLine(QPointF(titleRectF.bottomLeft().x(), separatorYCoOrd), QPointF(titleRectF.bottomRight().x(), separatorYCoOrd));
-        }
+        qreal separatorYCoOrd = qreal(titleRectF.bottom()) - qreal(key.separatorHeight) / 2;
+        painter->drawLine(QPointF(titleRectF.bottomLeft().x() + key.separatorInsetLeft, separatorYCoOrd),
+                          QPointF(titleRectF.bottomRight().x() - key.separatorInsetRight, separatorYCoOrd));
     }
 
     painter->restore();
-
-    // draw caption
-    painter->setFont(s->font());
-    painter->setPen(fontColor());
-    const auto cR = captionRect();
-    const QString caption = painter->fontMetrics().elidedText(c->caption(), Qt::ElideMiddle, cR.first.width());
-    painter->drawText(cR.first, cR.second | Qt::TextSingleLine, caption);
-
-    // draw all buttons
-    m_leftButtons->paint(painter, repaintRegion);
-    m_rightButtons->paint(painter, repaintRegion);
 }
 
 // outputs the icon size + padding to make a small button, the actual icon size, and the background size to make a small button
@@ -1453,11 +1743,14 @@ QPair<QRect, Qt::Alignment> Decoration::captionRect() const
         case InternalSettings::EnumTitleAlignment::AlignCenterFullWidth: {
             // full caption rect
             const QRect fullRect = QRect(0, yOffset, size().width(), captionHeight());
-            QRect boundingRect(settings()->fontMetrics().boundingRect(c->caption()).toRect());
+            if (m_captionWidthCaption != c->caption() || m_captionWidthFont != settings()->font()) {
+                m_captionWidthCaption = c->caption();
+                m_captionWidthFont = settings()->font();
+                m_captionWidth = settings()->fontMetrics().boundingRect(c->caption()).toRect().width();
+            }
 
             // text bounding rect
-            boundingRect.setTop(yOffset);
-            boundingRect.setHeight(captionHeight());
+            QRect boundingRect(0, yOffset, m_captionWidth, captionHeight());
             boundingRect.moveLeft((size().width() - boundingRect.width()) / 2);
 
             if (boundingRect.left() < leftOffset) {
@@ -1485,13 +1778,6 @@ void Decoration::updateShadow(const bool forceUpdateCache, bool noCache, const b
         return;
     }
 
-    // The preset exception may modify the shadow, so in this case there is a "noCache" property set - we don't want to cache the exception shadow as it may
-    // corrupt the shadow cache for normal non-exception decoration windows For shaded windows the shadow/outline has a potentially different shape so do not
-    // use the shadow cache when shaded
-    if (m_internalSettings->property("noCacheException").toBool() || c->isShaded()) {
-        noCache = true;
-    }
-
     // Animated case, no cached shadow object
     if ((m_shadowAnimation->state() == QAbstractAnimation::Running) && (m_shadowOpacity != 0.0) && (m_shadowOpacity != 1.0)) {
         QColor shadowColor = KColorUtils::mix(m_decorationColors->inactive()->shadow, m_decorationColors->active()->shadow, m_shadowOpacity);
@@ -1501,63 +1787,74 @@ void Decoration::updateShadow(const bool forceUpdateCache, bool noCache, const b
     }
     setThinWindowOutlineColor();
 
-    // TODO: Potentially make the kdecoration configwidget more intelligent and send a dbus signal which is aware of whether to update the shadow or not, so
-    // there is less processing here
-    // check if cached settings have changed, if so replace them with new settings values and regenerate the shadow cache
-    if (!noCache
-        && (
-
-            forceUpdateCache || g_shadowSizeEnum != m_internalSettings->shadowSize() || g_shadowStrength != m_internalSettings->shadowStrength()
-            || g_shadowColor != m_internalSettings->shadowColor() || !(qAbs(g_cornerRadius - m_scaledCornerRadius) < 0.001)
-            || !(qAbs(g_systemScaleFactor - m_systemScaleFactorX11) < 0.001) || g_hasNoBorders != hasNoBorders()
-            || g_roundBottomCornersWhenNoBorders != m_internalSettings->roundBottomCornersWhenNoBorders()
-            || g_thinWindowOutlineStyleActive != m_internalSettings->thinWindowOutlineStyle(true)
-            || g_thinWindowOutlineStyleInactive != m_internalSettings->thinWindowOutlineStyle(false)
-            || (c->isActive() ? g_thinWindowOutlineColorActive != m_thinWindowOutline : g_thinWindowOutlineColorInactive != m_thinWindowOutline)
-            || g_thinWindowOutlineThickness != m_internalSettings->thinWindowOutlineThickness())) {
-        g_sShadow.reset();
-        g_sShadowInactive.reset();
-        g_shadowSizeEnum = m_internalSettings->shadowSize();
-        g_shadowStrength = m_internalSettings->shadowStrength();
-        g_shadowColor = m_internalSettings->shadowColor();
-        g_cornerRadius = m_scaledCornerRadius;
-        g_systemScaleFactor = m_systemScaleFactorX11;
-        g_hasNoBorders = hasNoBorders();
-        g_roundBottomCornersWhenNoBorders = m_internalSettings->roundBottomCornersWhenNoBorders();
-        g_thinWindowOutlineStyleActive = m_internalSettings->thinWindowOutlineStyle(true);
-        g_thinWindowOutlineStyleInactive = m_internalSettings->thinWindowOutlineStyle(false);
-        c->isActive() ? g_thinWindowOutlineColorActive = m_thinWindowOutline : g_thinWindowOutlineColorInactive = m_thinWindowOutline;
-        g_thinWindowOutlineThickness = m_internalSettings->thinWindowOutlineThickness();
-    }
-
-    std::shared_ptr<KDecoration2::DecorationShadow> nonCachedShadow;
-    std::shared_ptr<KDecoration2::DecorationShadow> *shadow = nullptr;
-
-    if (noCache)
-        shadow = &nonCachedShadow;
-    else // use the already cached shadow
-        shadow = (c->isActive()) ? &g_sShadow : &g_sShadowInactive;
-
-    if (!(*shadow)) { // only recreate the shadow if necessary
-        QColor shadowColor = c->isActive() ? m_decorationColors->active()->shadow : m_decorationColors->inactive()->shadow;
-        *shadow = createShadowObject(shadowColor, isThinWindowOutlineOverride);
-    }
-
-    setShadow(*shadow);
+    if (forceUpdateCache) {
+        ShadowCache::self().clear();
+    }
+
+    const QColor shadowColor = c->isActive() ? m_decorationColors->active()->shadow : m_decorationColors->inactive()->shadow;
+
+    // transient shadows (e.g. mid-way through an outline colour animation) are not worth caching
+    if (noCache) {
+        setShadow(createShadowObject(shadowColor, isThinWindowOutlineOverride));
+        return;
+    }
+
+    // the cache key covers every shadow input, so windows with exceptions, presets or a shaded state share a shadow with any other window with the same
+    // parameters
+    const ShadowCacheKey key = shadowCacheKey(shadowColor, isThinWindowOutlineOverride);
+    std::shared_ptr<KDecoration2::DecorationShadow> shadow = ShadowCache::self().shadow(key);
+
+    if (!shadow) { // only recreate the shadow if necessary, preferably from the texture another process has already rendered
+        shadow = createShadowObject(shadowColor, isThinWindowOutlineOverride, shadowDiskCacheKey(key));
+        ShadowCache::self().insert(key, shadow);
+    }
+
+    setShadow(shadow);
+}
+
+//________________________________________________________________
+ShadowCacheKey Decoration::shadowCacheKey(const QColor &shadowColor, const bool isThinWindowOutlineOverride) const
+{
+    auto c = client();
+
+    ShadowCacheKey key;
+    key.shadowSize = m_internalSettings->shadowSize();
+    key.shadowStrength = m_internalSettings->shadowStrength();
+    key.shadowColor = shadowColor;
+    key.scaledCornerRadius = m_scaledCornerRadius;
+    key.windowCornerRadius = m_internalSettings->windowCornerRadius();
+    key.systemScaleFactor = m_systemScaleFactorX11;
+    key.hasNoBorders = hasNoBorders();
+    key.roundBottomCornersWhenNoBorders = m_internalSettings->roundBottomCornersWhenNoBorders();
+    key.shaded = c->isShaded();
+    key.thinWindowOutlineStyleActive = m_internalSettings->thinWindowOutlineStyle(true);
+    key.thinWindowOutlineStyleInactive = m_internalSettings->thinWindowOutlineStyle(false);
+    key.drawThinWindowOutline = !isWindowOutlineNone() || isThinWindowOutlineOverride;
+    key.thinWindowOutlineColor = m_thinWindowOutline;
+    key.thinWindowOutlineThickness = m_internalSettings->thinWindowOutlineThickness();
+    return key;
 }
 
 //________________________________________________________________
-std::shared_ptr<KDecoration2::DecorationShadow> Decoration::createShadowObject(QColor shadowColor, const bool isThinWindowOutlineOverride)
+bool Decoration::isWindowOutlineNone() const
 {
     auto c = client();
 
     // determine when a window outline does not need to be drawn (even when set to none, sometimes needs to be drawn if there is an animation)
-    bool windowOutlineNone =
-        ((m_internalSettings->thinWindowOutlineStyle(true) == InternalSettings::EnumThinWindowOutlineStyle::WindowOutlineNone
-          && m_internalSettings->thinWindowOutlineStyle(false) == InternalSettings::EnumThinWindowOutlineStyle::WindowOutlineNone)
-         || (m_animation->state() != QAbstractAnimation::Running
-             && ((c->isActive() && m_internalSettings->thinWindowOutlineStyle(true) == InternalSettings::EnumThinWindowOutlineStyle::WindowOutlineNone)
-                 || (!c->isActive() && m_internalSettings->thinWindowOutlineStyle(false) == InternalSettings::EnumThinWindowOutlineStyle::WindowOutlineNone))));
+    return ((m_internalSettings->thinWindowOutlineStyle(true) == InternalSettings::EnumThinWindowOutlineStyle::WindowOutlineNone
+             && m_internalSettings->thinWindowOutlineStyle(false) == InternalSettings::EnumThinWindowOutlineStyle::WindowOutlineNone)
+            || (m_animation->state() != QAbstractAnimation::Running
+                && ((c->isActive() && m_internalSettings->thinWindowOutlineStyle(true) == InternalSettings::EnumThinWindowOutlineStyle::WindowOutlineNone)
+                    || (!c->isActive() && m_internalSettings->thinWindowOutlineStyle(false) == InternalSettings::EnumThinWindowOutlineStyle::WindowOutlineNone))));
+}
+
+//________________________________________________________________
+std::shared_ptr<KDecoration2::DecorationShadow>
+Decoration::createShadowObject(QColor shadowColor, const bool isThinWindowOutlineOverride, const QByteArray &diskCacheKey)
+{
+    auto c = client();
+
+    const bool windowOutlineNone = isWindowOutlineNone();
 
     if (m_internalSettings->shadowSize() == InternalSettings::EnumShadowSize::ShadowNone && windowOutlineNone && !isThinWindowOutlineOverride) {
         return nullptr;
@@ -1568,17 +1865,32 @@ std::shared_ptr<KDecoration2::DecorationShadow> Decoration::createShadowObject(Q
     const QSize boxSize =
         BoxShadowRenderer::calculateMinimumBoxSize(params.shadow1.radius).expandedTo(BoxShadowRenderer::calculateMinimumBoxSize(params.shadow2.radius));
 
-    BoxShadowRenderer shadowRenderer;
-
-    shadowRenderer.setBorderRadius(m_scaledCornerRadius + 0.5);
-    shadowRenderer.setBoxSize(boxSize);
-    shadowRenderer.addShadow(params.shadow1.offset, params.shadow1.radius, ColorTools::alphaMix(shadowColor, params.shadow1.opacity));
-    shadowRenderer.addShadow(params.shadow2.offset, params.shadow2.radius, ColorTools::alphaMix(shadowColor, params.shadow2.opacity));
-
-    QImage shadowTexture = shadowRenderer.render();
+    QImage shadowTexture;
+    if (!diskCacheKey.isEmpty()) {
+        shadowTexture = ShadowDiskCache::load(diskCacheKey);
+    }
+    const bool loadedFromDiskCache = !shadowTexture.isNull();
+
+    if (!loadedFromDiskCache) {
+        // the blur only depends on the shadow geometry, so it is rendered once and then tinted -- colour changes and active state animations never re-blur
+        const ShadowMaskKey maskKey{m_internalSettings->shadowSize(), m_scaledCornerRadius + 0.5};
+        QVector<QImage> masks = ShadowCache::self().masks(maskKey);
+        if (masks.isEmpty()) {
+            BoxShadowRenderer shadowRenderer;
+
+            shadowRenderer.setBorderRadius(maskKey.borderRadius);
+            shadowRenderer.setBoxSize(boxSize);
+            shadowRenderer.addShadow(params.shadow1.offset, params.shadow1.radius, Qt::black);
+            shadowRenderer.addShadow(params.shadow2.offset, params.shadow2.radius, Qt::black);
+
+            masks = shadowRenderer.renderMasks();
+            ShadowCache::self().insertMasks(maskKey, masks);
+        }
 
-    QPainter painter(&shadowTexture);
-    painter.setRenderHint(QPainter::Antialiasing);
+        shadowTexture = BoxShadowRenderer::composite(
+            masks,
+            {ColorTools::alphaMix(shadowColor, params.shadow1.opacity), ColorTools::alphaMix(shadowColor, params.shadow2.opacity)});
+    }
 
     const QRect outerRect = shadowTexture.rect();
 
@@ -1592,6 +1904,19 @@ std::shared_ptr<KDecoration2::DecorationShadow> Decoration::createShadowObject(Q
                                       outerRect.bottom() - boxRect.bottom() - Metrics::Decoration_Shadow_Overlap + params.offset.y());
     const QRectF innerRect = outerRect - padding;
 
+    auto ret = std::make_shared<KDecoration2::DecorationShadow>();
+    ret->setPadding(padding);
+    ret->setInnerShadowRect(QRect(outerRect.center(), QSize(1, 1)));
+
+    // a texture from the disk cache already has the inner rect masked out and the outline drawn
+    if (loadedFromDiskCache) {
+        ret->setShadow(shadowTexture);
+        return ret;
+    }
+
+    QPainter painter(&shadowTexture);
+    painter.setRenderHint(QPainter::Antialiasing);
+
     painter.setPen(Qt::NoPen);
     painter.setBrush(Qt::black);
     painter.setCompositionMode(QPainter::CompositionMode_DestinationOut);
@@ -1661,9 +1986,10 @@ std::shared_ptr<KDecoration2::DecorationShadow> Decoration::createShadowObject(Q
     }
     painter.end();
 
-    auto ret = std::make_shared<KDecoration2::DecorationShadow>();
-    ret->setPadding(padding);
-    ret->setInnerShadowRect(QRect(outerRect.center(), QSize(1, 1)));
+    if (!diskCacheKey.isEmpty()) {
+        ShadowDiskCache::store(diskCacheKey, shadowTexture);
+    }
+
     ret->setShadow(shadowTexture);
     return ret;
 }
@@ -1796,14 +2122,38 @@ void Decoration::updateBlur()
 {
     // disable blur if the titlebar is opaque
     if (isOpaqueTitleBar()) { // opaque titlebar colours
-        setBlurRegion(QRegion());
+        setBlurRegionIfChanged(QRegion());
     } else { // transparent titlebar colours
         if (m_internalSettings->blurTransparentTitleBars()) { // enable blur
-            calculateWindowAndTitleBarShapes(true); // refreshes m_windowPath
-            setBlurRegion(QRegion(m_windowPath.toFillPolygon().toPolygon()));
+            calculateWindowAndTitleBarShapes(); // refreshes m_windowShapesKey
+            setBlurRegionIfChanged(windowRegion());
         } else
-            setBlurRegion(QRegion());
+            setBlurRegionIfChanged(QRegion());
+    }
+}
+
+QRegion Decoration::windowRegion() const
+{
+    // the region equivalent of m_windowPath, built without rasterising the path
+    const WindowShapesKey &key = m_windowShapesKey;
+    const bool rounded = key.alphaChannelSupported && !key.maximized;
+    if (key.shaded) {
+        return GeometryTools::roundedRegion(m_titleRect, rounded ? Corners(AllCorners) : Corners(), m_scaledCornerRadius);
+    } else if (rounded) {
+        return GeometryTools::roundedRegion(rect(), key.squareBottomCorners ? Corners(CornersTop) : Corners(AllCorners), m_scaledCornerRadius);
+    } else {
+        return QRegion(rect());
+    }
+}
+
+void Decoration::setBlurRegionIfChanged(const QRegion &region)
+{
+    // kwin recalculates the blur on every call, so avoid it when resizing has not changed the region
+    if (region == m_blurRegion) {
+        return;
     }
+    m_blurRegion = region;
+    setBlurRegion(region);
 }
 
 bool Decoration::isOpaqueTitleBar()
@@ -10,19 +10,25 @@
 
 #include "breeze.h"
 
+#include "animationclock.h"
 #include "breezesettings.h"
+#include "breezeshadowcache.h"
 #include "colortools.h"
 #include "decorationcolors.h"
+#include "settingschanges.h"
 
 #include <KDecoration2/DecoratedClient>
 #include <KDecoration2/Decoration>
 #include <KDecoration2/DecorationSettings>
 #include <KSharedConfig>
 
+#include <QHash>
 #include <QPainterPath>
 #include <QPalette>
+#include <QPixmap>
+#include <QRegion>
+#include <QStaticText>
 #include <QVariant>
-#include <QVariantAnimation>
 
 #include <memory>
 
@@ -40,6 +46,43 @@ enum struct ButtonBackgroundType {
     FullHeight,
 };
 
+//* inputs which determine the rendered titlebar background
+struct TitleBarBackgroundKey {
+    QSize size;
+    qreal devicePixelRatio = 1;
+    bool active = false;
+    bool gradient = false;
+    qreal cornerRadius = 0;
+    //* 0 = rectangular, 1 = rounded top corners, 2 = shaded
+    int shape = 0;
+    QRgb color = 0;
+    QRgb separatorColor = 0;
+    int separatorHeight = 0;
+    qreal separatorPenWidth = 0;
+    int separatorInsetLeft = 0;
+    int separatorInsetRight = 0;
+
+    bool operator==(const TitleBarBackgroundKey &other) const = default;
+};
+
+inline size_t qHash(const TitleBarBackgroundKey &key, size_t seed = 0)
+{
+    return qHashMulti(seed,
+                      key.size.width(),
+                      key.size.height(),
+                      key.devicePixelRatio,
+                      key.active,
+                      key.gradient,
+                      key.cornerRadius,
+                      key.shape,
+                      key.color,
+                      key.separatorColor,
+                      key.separatorHeight,
+                      key.separatorPenWidth,
+                      key.separatorInsetLeft,
+                      key.separatorInsetRight);
+}
+
 class Decoration : public KDecoration2::Decoration
 {
     Q_OBJECT
@@ -54,6 +97,14 @@ public:
     //* paint
     void paint(QPainter *painter, const QRect &repaintRegion) override;
 
+    //* geometry recalculations deferred until the next event loop iteration or paint(), so that several changes in one resize step cause one recalculation
+    enum PendingUpdate {
+        PendingTitleBar = 0x1,
+        PendingButtonsGeometry = 0x2,
+        PendingBlur = 0x4,
+    };
+    Q_DECLARE_FLAGS(PendingUpdates, PendingUpdate)
+
     //* internal settings
     InternalSettingsPtr internalSettings() const
     {
@@ -152,7 +203,7 @@ public:
         return m_rightButtons;
     }
 
-    QVariantAnimation *activeStateChangeAnimation()
+    ClockedAnimation *activeStateChangeAnimation()
     {
         return m_animation;
     }
@@ -181,6 +232,11 @@ private Q_SLOTS:
     {
         reconfigureMain(true);
     }
+    //* reconfigure following a KDecoration settings change, only updating the parts affected by changes to the settings
+    void reconfigureChangedSettings()
+    {
+        reconfigureMain(false, SettingsChangeNone);
+    }
     void generateDecorationColorsOnClientPaletteUpdate(const QPalette &clientPalette);
     void generateDecorationColorsOnDecorationColorSettingsUpdate(QByteArray uuid);
     void generateDecorationColorsOnSystemColorSettingsUpdate(QByteArray uuid);
@@ -201,13 +257,37 @@ private:
     //* return the rect in which caption will be drawn
     QPair<QRect, Qt::Alignment> captionRect() const;
 
-    void reconfigureMain(const bool noUpdateShadow = false);
+    //* return the region covered by the window borders, excluding the titlebar and client area
+    QRegion borderRegion() const;
+
+    //* reconfigure the given parts of the decoration, and any parts affected by changes to the settings since last reconfigured
+    void reconfigureMain(const bool noUpdateShadow = false, SettingsChanges changes = SettingsChangeAll);
+
+    //* fetch m_internalSettings from SettingsProvider if the settings snapshot has changed since last fetched, or if rematchExceptions and a different exception now matches the window. Returns true if changed
+    bool updateInternalSettings(const bool rematchExceptions = false);
+
     void updateDecorationColors(const QPalette &clientPalette, QByteArray uuid = "");
     void createButtons();
-    void calculateWindowAndTitleBarShapes(const bool windowShapeOnly = false);
+    //* update m_titleBarPath, m_windowPath and m_windowPathMinusTitleBar if any of the inputs to their shapes have changed
+    void calculateWindowAndTitleBarShapes();
     void paintTitleBar(QPainter *painter, const QRect &repaintRegion);
+    //* key for the titlebar background as it would currently be painted with the given painter
+    TitleBarBackgroundKey titleBarBackgroundKey(QPainter *painter) const;
+    //* paint the titlebar fill and separator
+    void renderTitleBarBackground(QPainter *painter, const TitleBarBackgroundKey &key) const;
+    //* paint the caption, laying it out again only if the caption, font or caption rect have changed
+    void paintCaption(QPainter *painter, const QRect &repaintRegion);
+    //* discard the cached caption layout
+    void invalidateCaptionLayout()
+    {
+        m_captionLayout = CaptionLayout();
+    }
     void updateShadow(const bool forceUpdateCache = false, bool noCache = false, const bool isThinWindowOutlineOverride = false);
-    std::shared_ptr<KDecoration2::DecorationShadow> createShadowObject(QColor shadowColor, const bool isThinWindowOutlineOverride = false);
+    //* renders the shadow; when diskCacheKey is non-empty the texture is loaded from, or stored to, ShadowDiskCache
+    std::shared_ptr<KDecoration2::DecorationShadow>
+    createShadowObject(QColor shadowColor, const bool isThinWindowOutlineOverride = false, const QByteArray &diskCacheKey = QByteArray());
+    ShadowCacheKey shadowCacheKey(const QColor &shadowColor, const bool isThinWindowOutlineOverride) const;
+    bool isWindowOutlineNone() const;
     void setScaledCornerRadius();
 
     //*@name border size
@@ -221,6 +301,51 @@ private:
     void setScaledTitleBarTopBottomMargins();
     void setScaledTitleBarSideMargins();
     bool isOpaqueTitleBar();
+    //* the region covered by the window shape, as last calculated by calculateWindowAndTitleBarShapes()
+    QRegion windowRegion() const;
+    //* set the blur region, unless it is already set to the given region
+    void setBlurRegionIfChanged(const QRegion &region);
+
+    //* mark recalculations as needed, and schedule them if not already scheduled
+    void scheduleUpdates(PendingUpdates updates);
+    //* perform any scheduled recalculations now
+    void flushPendingUpdates();
+    //* lay out the buttons if needed and position the right group for the current width, without requesting a repaint
+    void positionButtons();
+
+    //* inputs to the button layout, other than the window width
+    struct ButtonsLayoutKey {
+        const InternalSettings *internalSettings = nullptr;
+        quint64 settingsGeneration = 0;
+        int smallSpacing = 0;
+        int borderTop = 0;
+        int borderLeft = 0;
+        int borderRight = 0;
+        int captionHeight = 0;
+        int titleBarSeparatorHeight = 0;
+        int titleBarTopMargin = 0;
+        int titleBarLeftMargin = 0;
+        int titleBarRightMargin = 0;
+        qreal integratedRoundedRectangleBottomPadding = 0;
+        ButtonBackgroundType buttonBackgroundType = ButtonBackgroundType::Small;
+        int smallButtonPaddedSize = 0;
+        int iconSize = 0;
+        int smallButtonBackgroundSize = 0;
+        qreal systemScaleFactorX11 = 1;
+        bool maximized = false;
+        bool topEdge = false;
+        bool leftEdge = false;
+        bool rightEdge = false;
+        //* left then right buttons, each group terminated by nullptr
+        QVector<const void *> buttons;
+        QVector<bool> buttonsVisible;
+
+        bool operator==(const ButtonsLayoutKey &other) const = default;
+    };
+    ButtonsLayoutKey buttonsLayoutKey() const;
+
+    //* set the size, icon offsets and neighbour flags of every button, the group spacings, and the left group position
+    void layoutButtons();
     int titleBarSeparatorHeight() const;
     qreal devicePixelRatio(QPainter *painter) const;
 
@@ -237,21 +362,29 @@ private:
 
     static KSharedConfig::Ptr s_kdeGlobalConfig;
     InternalSettingsPtr m_internalSettings;
+
+    //* SettingsProvider generation m_internalSettings was fetched from
+    quint64 m_settingsGeneration = 0;
+
+    //* parts of the decoration affected by settings snapshots fetched since last reconfigured
+    SettingsChanges m_pendingSettingsChanges = SettingsChangeAll;
     KDecoration2::DecorationButtonGroup *m_leftButtons = nullptr;
     KDecoration2::DecorationButtonGroup *m_rightButtons = nullptr;
 
     //* Whether the paint() method is active
     bool m_painting = false;
 
-    //* Object to return decoration palette colours
-    std::unique_ptr<DecorationColors> m_decorationColors;
+    //* Object to return decoration palette colours, shared with decorations using the same client palette if that is not the system palette
+    std::shared_ptr<DecorationColors> m_decorationColors;
+    //* whether m_decorationColors is shared through SettingsProvider::clientPaletteColors()
+    bool m_decorationColorsShared = false;
 
     //* active state change animation
-    QVariantAnimation *m_animation;
+    ClockedAnimation *m_animation;
     //* shadow animation
-    QVariantAnimation *m_shadowAnimation;
+    ClockedAnimation *m_shadowAnimation;
     //*window outline animation when "Colourize with highlighted button'a colour ticked"
-    QVariantAnimation *m_overrideOutlineFromButtonAnimation;
+    ClockedAnimation *m_overrideOutlineFromButtonAnimation;
 
     //* active state change animation opacity
     qreal m_opacity = 0;
@@ -283,6 +416,57 @@ private:
     QPainterPath m_titleBarPath = QPainterPath();
     //* Exact window path, with clipped rounded corners
     QPainterPath m_windowPath = QPainterPath();
+    //* Exact window path below the titlebar
+    QPainterPath m_windowPathMinusTitleBar = QPainterPath();
+
+    //* inputs from which the above paths were last calculated
+    struct WindowShapesKey {
+        QSize size;
+        int titleBarHeight = -1;
+        qreal cornerRadius = 0;
+        bool maximized = false;
+        bool shaded = false;
+        bool alphaChannelSupported = false;
+        bool squareBottomCorners = false;
+
+        bool operator==(const WindowShapesKey &other) const = default;
+    };
+    WindowShapesKey m_windowShapesKey;
+
+    //* the blur region last passed to setBlurRegion()
+    QRegion m_blurRegion;
+
+    //* recalculations scheduled by scheduleUpdates() and not yet performed
+    PendingUpdates m_pendingUpdates;
+
+    //* inputs from which the buttons were last laid out
+    ButtonsLayoutKey m_buttonsLayoutKey;
+    //* right button group placement from the last layout, used to position the group for the current width
+    bool m_rightButtonsLaidOut = false;
+    qreal m_rightButtonsInset = 0;
+    int m_rightButtonsVerticalPadding = 0;
+
+    //* rendered static titlebar backgrounds; holds at most the active and inactive backgrounds for the current size and scale
+    QHash<TitleBarBackgroundKey, QPixmap> m_titleBarBackgroundCache;
+    //* titlebar size and device pixel ratio of the previous paint
+    QSize m_titleBarBackgroundSize;
+    qreal m_titleBarBackgroundDevicePixelRatio = 0;
+
+    //* laid-out caption, reused by repaints which do not change the caption text, font or caption rect
+    struct CaptionLayout {
+        QString caption;
+        QFont font;
+        QRect rect;
+        Qt::Alignment alignment;
+        QStaticText text;
+        QPointF position;
+    };
+    CaptionLayout m_captionLayout;
+
+    //* width of the unelided caption, used to position a full-width centred caption
+    mutable QString m_captionWidthCaption;
+    mutable QFont m_captionWidthFont;
+    mutable int m_captionWidth = 0;
 
     qreal m_systemScaleFactorX11 = 1.0;
 
@@ -305,6 +489,8 @@ private:
     bool m_animateOutOverriddenThinWindowOutline = false;
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(Decoration::PendingUpdates)
+
 bool Decoration::hasBorders() const
 {
     if (m_internalSettings && m_internalSettings->exceptionBorder()) {
@@ -7,10 +7,16 @@
 
 #include "breezesettingsprovider.h"
 #include "dbusmessages.h"
+#include "dbusupdatenotifier.h"
 #include "decorationexceptionlist.h"
 #include "presetsmodel.h"
 
-#include <QRegularExpression>
+#include <KColorScheme>
+
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
 #include <QTextStream>
 
 namespace Breeze
@@ -21,9 +27,45 @@ SettingsProvider *SettingsProvider::s_self = nullptr;
 //__________________________________________________________________
 SettingsProvider::SettingsProvider()
     : m_config(KSharedConfig::openConfig(QStringLiteral("klassy/klassyrc")))
+    , m_kdeGlobalConfig(KSharedConfig::openConfig())
     , m_presetsConfig(KSharedConfigPtr())
 {
-    m_defaultSettings = InternalSettingsPtr(new InternalSettings());
+    // connected before any decoration connects to these signals, so the snapshot is always invalidated before decorations respond
+    connect(&g_dBusUpdateNotifier, &DBusUpdateNotifier::decorationSettingsUpdate, this, &SettingsProvider::invalidate);
+    connect(&g_dBusUpdateNotifier, &DBusUpdateNotifier::systemColorSchemeUpdate, this, &SettingsProvider::invalidate);
+    connect(&g_dBusUpdateNotifier, &DBusUpdateNotifier::decorationSettingsChanges, this, &SettingsProvider::setPendingChanges);
+
+    // kdeglobals changes are relayed to decorations through globalSettingsChanged(), so that kdeglobals is reparsed before any decoration reconfigures
+    QDBusConnection::sessionBus().connect(QString(),
+                                          QStringLiteral("/KGlobalSettings"),
+                                          QStringLiteral("org.kde.KGlobalSettings"),
+                                          QStringLiteral("notifyChange"),
+                                          this,
+                                          SLOT(onGlobalSettingsNotifyChange()));
+
+    // one tablet mode match rule and query for the whole process, rather than one per decoration
+    QDBusConnection::sessionBus().connect(QStringLiteral("org.kde.KWin"),
+                                          QStringLiteral("/org/kde/KWin"),
+                                          QStringLiteral("org.kde.KWin.TabletModeManager"),
+                                          QStringLiteral("tabletModeChanged"),
+                                          QStringLiteral("b"),
+                                          this,
+                                          SLOT(onTabletModeChanged(bool)));
+
+    auto message = QDBusMessage::createMethodCall(QStringLiteral("org.kde.KWin"),
+                                                  QStringLiteral("/org/kde/KWin"),
+                                                  QStringLiteral("org.freedesktop.DBus.Properties"),
+                                                  QStringLiteral("Get"));
+    message.setArguments({QStringLiteral("org.kde.KWin.TabletModeManager"), QStringLiteral("tabletMode")});
+    auto call = new QDBusPendingCallWatcher(QDBusConnection::sessionBus().asyncCall(message), this);
+    connect(call, &QDBusPendingCallWatcher::finished, this, [this, call]() {
+        QDBusPendingReply<QVariant> reply = *call;
+        if (!reply.isError()) {
+            onTabletModeChanged(reply.value().toBool());
+        }
+
+        call->deleteLater();
+    });
 }
 
 //__________________________________________________________________
@@ -44,64 +86,116 @@ SettingsProvider *SettingsProvider::self()
 }
 
 //__________________________________________________________________
-void SettingsProvider::reconfigure()
+void SettingsProvider::watchDecorationSettings(const std::shared_ptr<KDecoration2::DecorationSettings> &decorationSettings)
 {
-    m_defaultSettings->load();
+    const KDecoration2::DecorationSettings *settings = decorationSettings.get();
+    if (!settings || m_watchedDecorationSettings.contains(settings)) {
+        return;
+    }
 
-    DecorationExceptionList exceptions;
-    exceptions.readConfig(m_config);
-    m_exceptions = exceptions.getDefault();
-    m_exceptions.append(exceptions.get());
+    m_watchedDecorationSettings.insert(settings);
+    connect(settings, &KDecoration2::DecorationSettings::reconfigured, this, &SettingsProvider::invalidateOnReconfigured);
+    connect(settings, &QObject::destroyed, this, [this, settings]() {
+        m_watchedDecorationSettings.remove(settings);
+    });
 }
 
 //__________________________________________________________________
-InternalSettingsPtr SettingsProvider::internalSettings(Decoration *decoration)
+void SettingsProvider::invalidate()
 {
-    // get the client
-    auto client = decoration->client();
+    m_stale = true;
+}
 
-    for (auto internalSettings : std::as_const(m_exceptions)) {
-        // discard disabled exceptions
-        if (!internalSettings->enabled()) {
-            continue;
-        }
+//__________________________________________________________________
+void SettingsProvider::invalidateOnReconfigured()
+{
+    m_stale = true;
+    m_completePendingChanges = true;
+}
 
-        // discard exceptions with empty exception pattern
-        if (internalSettings->exceptionWindowPropertyPattern().isEmpty()) {
-            continue;
-        }
+//__________________________________________________________________
+void SettingsProvider::onGlobalSettingsNotifyChange()
+{
+    invalidate();
+    Q_EMIT globalSettingsChanged();
+}
 
-        /*
-        decide which windowPropertyValue is to be compared
-        to the regular expression, based on exception type
-        */
-        QString windowPropertyValue;
-        switch (internalSettings->exceptionWindowPropertyType()) {
-        case InternalSettings::EnumExceptionWindowPropertyType::ExceptionWindowTitle: {
-            windowPropertyValue = client->caption();
-            break;
-        }
+//__________________________________________________________________
+void SettingsProvider::onTabletModeChanged(bool mode)
+{
+    if (mode == m_tabletMode) {
+        return;
+    }
+    m_tabletMode = mode;
+    Q_EMIT tabletModeChanged(mode);
+}
 
-        default:
-        case InternalSettings::EnumExceptionWindowPropertyType::ExceptionWindowClassName: {
-            windowPropertyValue = client->windowClass(); // windowClass() available from KDecoration 5.27 onwards
-            break;
-        }
-        }
+//__________________________________________________________________
+void SettingsProvider::setPendingChanges(SettingsChanges changes)
+{
+    m_pendingChanges = m_pendingChanges.value_or(SettingsChangeNone) | changes;
+}
 
-        // check matching
-        QRegularExpression rx(internalSettings->exceptionWindowPropertyPattern());
-        if (rx.match(windowPropertyValue).hasMatch()) {
-            // load preset if set
-            if (!internalSettings->exceptionPreset().isEmpty()) {
-                if (!m_presetsConfig) {
-                    KSharedConfigPtr presetsConfig = KSharedConfig::openConfig(QStringLiteral("klassy/windecopresetsrc"));
-                    m_presetsConfig.swap(presetsConfig);
-                }
-                if (!m_presetsConfig) {
-                    return internalSettings;
-                }
+//__________________________________________________________________
+SettingsChanges SettingsProvider::changes()
+{
+    reconfigure();
+    return m_snapshot->changes;
+}
+
+//__________________________________________________________________
+quint64 SettingsProvider::generation()
+{
+    reconfigure();
+    return m_snapshot->generation;
+}
+
+//__________________________________________________________________
+void SettingsProvider::reconfigure()
+{
+    if (!m_stale && m_snapshot) {
+        return;
+    }
+    m_stale = false;
+
+    m_config->reparseConfiguration();
+    m_kdeGlobalConfig->reparseConfiguration();
+    if (m_presetsConfig) {
+        m_presetsConfig->reparseConfiguration();
+    }
+
+    auto snapshot = std::make_shared<SettingsSnapshot>();
+    snapshot->generation = m_snapshot ? m_snapshot->generation + 1 : 1;
+
+    // the KCM reports its changes before the colour cache update and KWin reconfiguration that it triggers, and the KWin reconfiguration is the last
+    // rebuild to apply them to. Rebuilds with no report from the KCM can have had any setting changed
+    snapshot->changes = m_pendingChanges.value_or(SettingsChangeAll);
+    if (m_completePendingChanges) {
+        m_pendingChanges.reset();
+        m_completePendingChanges = false;
+    }
 
+    snapshot->defaultSettings = InternalSettingsPtr(new InternalSettings());
+    snapshot->defaultSettings->load();
+
+    DecorationExceptionList exceptions;
+    exceptions.readConfig(m_config);
+    snapshot->exceptions = exceptions.getDefault();
+    snapshot->exceptions.append(exceptions.get());
+
+    // apply presets now rather than on each match, so that the snapshot is not modified once shared
+    for (const auto &internalSettings : std::as_const(snapshot->exceptions)) {
+        if (!internalSettings->enabled() || internalSettings->exceptionWindowPropertyPattern().isEmpty()) {
+            continue;
+        }
+
+        // load preset if set
+        if (!internalSettings->exceptionPreset().isEmpty()) {
+            if (!m_presetsConfig) {
+                KSharedConfigPtr presetsConfig = KSharedConfig::openConfig(QStringLiteral("klassy/windecopresetsrc"));
+                m_presetsConfig.swap(presetsConfig);
+            }
+            if (m_presetsConfig) {
                 // load the preset values into internalSettings if a preset is set as an exception
                 PresetsModel::loadPreset(internalSettings.data(), m_presetsConfig.data(), internalSettings->exceptionPreset());
 
@@ -118,14 +212,102 @@ InternalSettingsPtr SettingsProvider::internalSettings(Decoration *decoration)
                                               true); // this property is to indicate not to cache shadows or colours for an exception with a Preset
                                                      // -- this is because the Preset exception can alter shadows and colours
             }
-            if (internalSettings->opaqueTitleBar()) {
-                internalSettings->setProperty("noCacheException", true);
-            }
-            return internalSettings;
         }
+        if (internalSettings->opaqueTitleBar()) {
+            internalSettings->setProperty("noCacheException", true);
+        }
+    }
+
+    m_exceptionMatcher.compile(snapshot->exceptions);
+    m_snapshot = std::move(snapshot);
+}
+
+//__________________________________________________________________
+const QPalette &SettingsProvider::systemPalette()
+{
+    // kdeglobals is reparsed by reconfigure(), which also advances the generation
+    const quint64 currentGeneration = generation();
+    if (m_systemPaletteGeneration != currentGeneration) {
+        m_systemPalette = KColorScheme::createApplicationPalette(m_kdeGlobalConfig);
+        m_systemPaletteHash = paletteHash(m_systemPalette);
+        m_systemPaletteGeneration = currentGeneration;
+    }
+    return m_systemPalette;
+}
+
+//__________________________________________________________________
+size_t SettingsProvider::systemPaletteHash()
+{
+    systemPalette();
+    return m_systemPaletteHash;
+}
+
+//__________________________________________________________________
+size_t SettingsProvider::paletteHash(const QPalette &palette)
+{
+    const qint64 cacheKey = palette.cacheKey();
+    auto it = m_paletteHashes.constFind(cacheKey);
+    if (it != m_paletteHashes.constEnd()) {
+        return it.value();
+    }
+
+    size_t hash = 0;
+    for (int group = 0; group < QPalette::NColorGroups; ++group) {
+        for (int role = 0; role < QPalette::NColorRoles; ++role) {
+            const QRgba64 color = palette.color(QPalette::ColorGroup(group), QPalette::ColorRole(role)).rgba64();
+            hash = qHashMulti(hash, quint64(color));
+        }
+    }
+
+    // client palettes are few and long-lived, but bound the table in case an application keeps changing its palette
+    if (m_paletteHashes.size() >= 64) {
+        m_paletteHashes.clear();
+    }
+    m_paletteHashes.insert(cacheKey, hash);
+    return hash;
+}
+
+//__________________________________________________________________
+std::shared_ptr<DecorationColors> SettingsProvider::clientPaletteColors(const ClientPaletteColorsKey &key)
+{
+    if (std::shared_ptr<DecorationColors> colors = m_clientPaletteColors.value(key).lock()) {
+        return colors;
+    }
+
+    // drop entries no longer used by any decoration, such as those from previous settings generations
+    if (m_clientPaletteColors.size() >= 32) {
+        m_clientPaletteColors.removeIf([](const auto &it) {
+            return it.value().expired();
+        });
+    }
+
+    auto colors = std::make_shared<DecorationColors>(false);
+    m_clientPaletteColors.insert(key, colors);
+    return colors;
+}
+
+//__________________________________________________________________
+bool SettingsProvider::hasTitleExceptions()
+{
+    reconfigure();
+    return m_exceptionMatcher.hasTitlePatterns();
+}
+
+//__________________________________________________________________
+InternalSettingsPtr SettingsProvider::internalSettings(Decoration *decoration)
+{
+    reconfigure();
+
+    // get the client
+    auto client = decoration->client();
+
+    const int index = m_exceptionMatcher.matchWindow(client->windowClass(), // windowClass() available from KDecoration 5.27 onwards
+                                                     client->caption());
+    if (index >= 0) {
+        return m_snapshot->exceptions.at(index);
     }
 
-    return m_defaultSettings;
+    return m_snapshot->defaultSettings;
 }
 
 }
@@ -8,15 +8,69 @@
 
 #include "breeze.h"
 #include "breezedecoration.h"
+#include "decorationcolors.h"
 #include "breezesettings.h"
+#include "exceptionmatcher.h"
+#include "settingschanges.h"
 
+#include <KDecoration2/DecorationSettings>
 #include <KSharedConfig>
 
+#include <QHash>
 #include <QObject>
+#include <QPalette>
+#include <QSet>
+
+#include <memory>
+#include <optional>
 
 namespace Breeze
 {
 
+/**
+ * @brief Immutable settings loaded from klassyrc, with any exception presets already applied.
+ *        A new snapshot is built once per change notification and shared by all decorations.
+ */
+struct SettingsSnapshot {
+    //* incremented for each rebuilt snapshot; decorations compare this to know if their settings are stale
+    quint64 generation = 0;
+
+    //* default configuration
+    InternalSettingsPtr defaultSettings;
+
+    //* exceptions
+    InternalSettingsList exceptions;
+
+    //* parts of the decoration affected since the previous snapshot
+    SettingsChanges changes = SettingsChangeAll;
+};
+
+//* identifies decoration colours generated for a client palette which differs from the system palette
+struct ClientPaletteColorsKey {
+    size_t paletteHash = 0;
+    //* settings snapshot generation; settings objects are only reused within a generation
+    quint64 settingsGeneration = 0;
+    const InternalSettings *settings = nullptr;
+    QRgb titleBarTextActive = 0;
+    QRgb titleBarBaseActive = 0;
+    QRgb titleBarTextInactive = 0;
+    QRgb titleBarBaseInactive = 0;
+
+    bool operator==(const ClientPaletteColorsKey &other) const = default;
+};
+
+inline size_t qHash(const ClientPaletteColorsKey &key, size_t seed = 0)
+{
+    return qHashMulti(seed,
+                      key.paletteHash,
+                      key.settingsGeneration,
+                      key.settings,
+                      key.titleBarTextActive,
+                      key.titleBarBaseActive,
+                      key.titleBarTextInactive,
+                      key.titleBarBaseInactive);
+}
+
 class SettingsProvider : public QObject
 {
     Q_OBJECT
@@ -28,27 +82,108 @@ public:
     //* singleton
     static SettingsProvider *self();
 
+    //* invalidate the snapshot whenever the given KDecoration settings are reconfigured, connecting only once per settings object.
+    //* Must be called before the decoration connects to the reconfigured signal itself, so the snapshot is invalidated first.
+    void watchDecorationSettings(const std::shared_ptr<KDecoration2::DecorationSettings> &decorationSettings);
+
+    //* generation of the current snapshot, rebuilding it first if it has been invalidated
+    quint64 generation();
+
+    //* parts of the decoration affected by the current snapshot since the previous one
+    SettingsChanges changes();
+
+    //* whether any exception matches on window title, so that a caption change may change a decoration's settings
+    bool hasTitleExceptions();
+
     //* internal settings for given decoration
     InternalSettingsPtr internalSettings(Decoration *);
 
+    //* system application palette from kdeglobals, rebuilt once per snapshot generation rather than once per decoration
+    const QPalette &systemPalette();
+
+    //* paletteHash() of systemPalette()
+    size_t systemPaletteHash();
+
+    //* hash of all colours of the given palette, for cheap comparison. Memoised by QPalette::cacheKey(), which copies of a palette share
+    size_t paletteHash(const QPalette &palette);
+
+    //* non-cached decoration colours shared by all decorations whose client palette matches the key, so that windows using the same
+    //* application colour scheme generate their colours once. Returns a new, ungenerated object if none is in use for the key
+    std::shared_ptr<DecorationColors> clientPaletteColors(const ClientPaletteColorsKey &key);
+
+    //* KWin tablet mode state, as last reported over D-Bus
+    bool tabletMode() const
+    {
+        return m_tabletMode;
+    }
+
+Q_SIGNALS:
+    //* emitted on a KGlobalSettings change notification, after the snapshot has been invalidated
+    void globalSettingsChanged();
+
+    //* emitted when KWin's tablet mode state changes
+    void tabletModeChanged(bool mode);
+
 public Q_SLOTS:
 
-    //* reconfigure
-    void reconfigure();
+    //* mark the snapshot as stale; it is rebuilt on next use, so a broadcast to many decorations reloads the settings once
+    void invalidate();
+
+    //* mark the snapshot as stale following a KDecoration reconfiguration, which completes a change reported by setPendingChanges()
+    void invalidateOnReconfigured();
+
+    //* record the changes reported by the KCM, applied to snapshots until the reconfiguration which follows
+    void setPendingChanges(SettingsChanges changes);
+
+private Q_SLOTS:
+    void onGlobalSettingsNotifyChange();
+    void onTabletModeChanged(bool mode);
 
 private:
     //* constructor
     SettingsProvider();
 
-    //* default configuration
-    InternalSettingsPtr m_defaultSettings;
+    //* rebuild the snapshot if stale
+    void reconfigure();
 
-    //* exceptions
-    InternalSettingsList m_exceptions;
+    //* current snapshot
+    std::shared_ptr<const SettingsSnapshot> m_snapshot;
+
+    //* exception patterns of m_snapshot
+    ExceptionMatcher m_exceptionMatcher;
+
+    //* whether m_snapshot needs to be rebuilt
+    bool m_stale = true;
+
+    //* changes reported by the KCM but not yet completed by a KDecoration reconfiguration. Unset means unknown, so everything is updated
+    std::optional<SettingsChanges> m_pendingChanges;
+
+    //* whether the next rebuild completes m_pendingChanges
+    bool m_completePendingChanges = false;
+
+    //* KWin tablet mode state
+    bool m_tabletMode = false;
+
+    //* cached system palette, and the snapshot generation it was built for
+    QPalette m_systemPalette;
+    size_t m_systemPaletteHash = 0;
+    quint64 m_systemPaletteGeneration = 0;
+
+    //* palette hashes, by QPalette::cacheKey()
+    QHash<qint64, size_t> m_paletteHashes;
+
+    //* decoration colours for client palettes, held only while a decoration uses them
+    QHash<ClientPaletteColorsKey, std::weak_ptr<DecorationColors>> m_clientPaletteColors;
+
+    //* KDecoration settings objects whose reconfigured signal is connected to invalidate()
+    QSet<const KDecoration2::DecorationSettings *> m_watchedDecorationSettings;
 
     //* config object
     KSharedConfigPtr m_config;
 
+    //* kdeglobals config object, shared with Decoration
+    KSharedConfigPtr m_kdeGlobalConfig;
+
     //* presets config object
     KSharedConfigPtr m_presetsConfig;
 
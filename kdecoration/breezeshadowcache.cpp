@@ -0,0 +1,111 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Paul A McAuley <kde@paulmcauley.com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "breezeshadowcache.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace Breeze
+{
+
+size_t qHash(const ShadowCacheKey &key, size_t seed)
+{
+    return qHashMulti(seed,
+                      key.shadowSize,
+                      key.shadowStrength,
+                      key.shadowColor.rgba(),
+                      key.scaledCornerRadius,
+                      key.windowCornerRadius,
+                      key.systemScaleFactor,
+                      key.hasNoBorders,
+                      key.roundBottomCornersWhenNoBorders,
+                      key.shaded,
+                      key.thinWindowOutlineStyleActive,
+                      key.thinWindowOutlineStyleInactive,
+                      key.drawThinWindowOutline,
+                      key.thinWindowOutlineColor.rgba(),
+                      key.thinWindowOutlineThickness);
+}
+
+size_t qHash(const ShadowMaskKey &key, size_t seed)
+{
+    return qHashMulti(seed, key.shadowSize, key.borderRadius);
+}
+
+ShadowCache &ShadowCache::self()
+{
+    static ShadowCache s_self;
+    return s_self;
+}
+
+std::shared_ptr<KDecoration2::DecorationShadow> ShadowCache::shadow(const ShadowCacheKey &key)
+{
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        return nullptr;
+    }
+
+    it->lastUsed = ++m_usageCounter;
+    return it->shadow;
+}
+
+void ShadowCache::insert(const ShadowCacheKey &key, const std::shared_ptr<KDecoration2::DecorationShadow> &shadow)
+{
+    if (!shadow) {
+        return;
+    }
+
+    m_entries.insert(key, Entry{shadow, ++m_usageCounter});
+    evictUnused();
+}
+
+QVector<QImage> ShadowCache::masks(const ShadowMaskKey &key) const
+{
+    return m_masks.value(key);
+}
+
+void ShadowCache::insertMasks(const ShadowMaskKey &key, const QVector<QImage> &masks)
+{
+    // the number of distinct mask geometries is small, so simply start afresh if it grows
+    if (m_masks.size() >= s_maxMaskEntries) {
+        m_masks.clear();
+    }
+    m_masks.insert(key, masks);
+}
+
+void ShadowCache::clear()
+{
+    m_entries.clear();
+    m_masks.clear();
+    m_usageCounter = 0;
+}
+
+void ShadowCache::evictUnused()
+{
+    // an entry whose shadow is only referenced by the cache is not used by any decoration
+    std::vector<std::pair<quint64, ShadowCacheKey>> unused;
+    for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+        if (it->shadow.use_count() == 1) {
+            unused.emplace_back(it->lastUsed, it.key());
+        }
+    }
+
+    if (unused.size() <= s_maxUnusedEntries) {
+        return;
+    }
+
+    std::sort(unused.begin(), unused.end(), [](const auto &a, const auto &b) {
+        return a.first < b.first;
+    });
+
+    const size_t numberToEvict = unused.size() - s_maxUnusedEntries;
+    for (size_t i = 0; i < numberToEvict; i++) {
+        m_entries.remove(unused[i].second);
+    }
+}
+
+}
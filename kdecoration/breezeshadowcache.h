@@ -0,0 +1,105 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Paul A McAuley <kde@paulmcauley.com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#pragma once
+
+#include <KDecoration2/DecorationShadow>
+
+#include <QColor>
+#include <QHash>
+#include <QImage>
+#include <QVector>
+
+#include <memory>
+
+namespace Breeze
+{
+
+//* every input which affects the rendered shadow texture of a decoration
+struct ShadowCacheKey {
+    int shadowSize = 0;
+    int shadowStrength = 0;
+    QColor shadowColor;
+    qreal scaledCornerRadius = 0;
+    qreal windowCornerRadius = 0;
+    qreal systemScaleFactor = 1;
+    bool hasNoBorders = false;
+    bool roundBottomCornersWhenNoBorders = false;
+    bool shaded = false;
+    int thinWindowOutlineStyleActive = 0;
+    int thinWindowOutlineStyleInactive = 0;
+    bool drawThinWindowOutline = false;
+    QColor thinWindowOutlineColor;
+    qreal thinWindowOutlineThickness = 1;
+
+    bool operator==(const ShadowCacheKey &other) const = default;
+};
+
+size_t qHash(const ShadowCacheKey &key, size_t seed = 0);
+
+//* the inputs which affect the blurred, colour-independent shadow masks
+struct ShadowMaskKey {
+    int shadowSize = 0;
+    qreal borderRadius = 0;
+
+    bool operator==(const ShadowMaskKey &other) const = default;
+};
+
+size_t qHash(const ShadowMaskKey &key, size_t seed = 0);
+
+/**
+ * @brief Process-wide cache of decoration shadows, so that decorations with identical shadow parameters share one KDecoration2::DecorationShadow.
+ *        Shadows held by a decoration are reference-counted by their shared_ptr and are never evicted;
+ *        unreferenced shadows are kept for re-use and evicted least-recently-used first.
+ */
+class ShadowCache
+{
+public:
+    //* singleton
+    static ShadowCache &self();
+
+    //* returns the cached shadow for the key, or nullptr if not cached
+    std::shared_ptr<KDecoration2::DecorationShadow> shadow(const ShadowCacheKey &key);
+
+    //* add a shadow to the cache
+    void insert(const ShadowCacheKey &key, const std::shared_ptr<KDecoration2::DecorationShadow> &shadow);
+
+    //* returns the cached blurred shadow masks for the key, or an empty list if not cached
+    QVector<QImage> masks(const ShadowMaskKey &key) const;
+
+    //* add blurred shadow masks to the cache
+    void insertMasks(const ShadowMaskKey &key, const QVector<QImage> &masks);
+
+    //* remove all cached shadows and masks
+    void clear();
+
+private:
+    ShadowCache() = default;
+
+    //* drop least-recently-used shadows which are no longer referenced by any decoration
+    void evictUnused();
+
+    struct Entry {
+        std::shared_ptr<KDecoration2::DecorationShadow> shadow;
+        quint64 lastUsed = 0;
+    };
+
+    QHash<ShadowCacheKey, Entry> m_entries;
+
+    //* blurred masks, tinted on demand so colour changes and animations never need to re-blur
+    QHash<ShadowMaskKey, QVector<QImage>> m_masks;
+
+    //* monotonic usage counter for LRU ordering
+    quint64 m_usageCounter = 0;
+
+    //* maximum number of shadows kept which are not used by any decoration
+    static constexpr size_t s_maxUnusedEntries = 8;
+
+    //* maximum number of sets of blurred masks kept
+    static constexpr int s_maxMaskEntries = 8;
+};
+
+}
@@ -13,6 +13,7 @@
 #include "decorationexceptionlist.h"
 #include "presetsmodel.h"
 #include "renderdecorationbuttonicon.h"
+#include "settingschanges.h"
 
 #include <KLocalizedString>
 
@@ -254,6 +255,12 @@ void ConfigWidget::save()
 
 void ConfigWidget::saveMain(QString saveAsPresetName)
 {
+    // keep the previous settings to determine what has changed
+    InternalSettings previousSettings;
+    previousSettings.load();
+    DecorationExceptionList previousExceptions;
+    previousExceptions.readConfig(m_configuration);
+
     // create internal settings and load from rc files
     m_internalSettings = InternalSettingsPtr(new InternalSettings());
     m_internalSettings->load();
@@ -295,6 +302,14 @@ void ConfigWidget::saveMain(QString saveAsPresetName)
     // sync configuration for exceptions
     m_configuration->sync();
 
+    // determine which parts of the decorations need updating
+    InternalSettings savedSettings;
+    savedSettings.load();
+    DecorationExceptionList savedExceptions;
+    savedExceptions.readConfig(m_configuration);
+    SettingsChanges changes = SettingsChangesModel::diff(&previousSettings, &savedSettings)
+        | SettingsChangesModel::diff(previousExceptions.getDefault() + previousExceptions.get(), savedExceptions.getDefault() + savedExceptions.get());
+
     setNeedsSave(false);
     Q_EMIT saved();
 
@@ -308,8 +323,18 @@ void ConfigWidget::saveMain(QString saveAsPresetName)
         PresetsModel::writePreset(m_internalSettings.data(), m_presetsConfiguration.data(), saveAsPresetName);
         // sync configuration for presets
         m_presetsConfiguration->sync();
+
+        // exceptions using the overwritten preset take their values from it rather than from klassyrc
+        for (const InternalSettingsPtr &exception : savedExceptions.getDefault() + savedExceptions.get()) {
+            if (exception->exceptionPreset() == saveAsPresetName) {
+                changes |= SettingsChangeAll;
+                break;
+            }
+        }
     }
 
+    // must be sent before the other messages so that the decorations know what the reload affects
+    DBusMessages::decorationSettingsChanges(uint(changes));
     DBusMessages::updateDecorationColorCache();
     // needed to tell kwin to reload when running from external kcmshell
     DBusMessages::kwinReloadConfig();
@@ -9,7 +9,6 @@
 #include "decorationexceptionlist.h"
 #include "presetsmodel.h"
 
-#include <QRegularExpression>
 #include <QTextStream>
 
 namespace Breeze
@@ -51,43 +50,35 @@ void DecorationSettingsProvider::reconfigure()
     exceptions.readConfig(m_config);
     m_exceptions = exceptions.getDefault();
     m_exceptions.append(exceptions.get());
+    m_exceptionMatcher.compile(m_exceptions);
 }
 
 //__________________________________________________________________
 InternalSettingsPtr DecorationSettingsProvider::internalSettings()
 {
-    for (auto internalSettings : std::as_const(m_exceptions)) {
-        // discard disabled exceptions
-        if (!internalSettings->enabled())
-            continue;
+    const int index = m_exceptionMatcher.matchProgramName(qAppName());
+    if (index >= 0) {
+        auto internalSettings = m_exceptions.at(index);
 
-        // discard exceptions with empty exception pattern
-        if (internalSettings->exceptionProgramNamePattern().isEmpty())
-            continue;
-
-        // check matching
-        QRegularExpression rx(internalSettings->exceptionProgramNamePattern());
-        if (rx.match(qAppName()).hasMatch()) {
-            // load window decoration preset if set
-            if (!internalSettings->exceptionPreset().isEmpty()) {
-                if (!m_presetsConfig) {
-                    KSharedConfigPtr presetsConfig = KSharedConfig::openConfig(QStringLiteral("klassy/windecopresetsrc"));
-                    m_presetsConfig.swap(presetsConfig);
-                }
-                if (!m_presetsConfig) {
-                    return internalSettings;
-                }
-
-                PresetsModel::loadPreset(internalSettings.data(), m_presetsConfig.data(), internalSettings->exceptionPreset());
-                internalSettings->setProperty("noCacheException",
-                                              true); // this property is to indicate not to cache shadows or colours for an exception with a Preset
-                                                     // -- this is because the Preset exception can alter shadows and colours
+        // load window decoration preset if set
+        if (!internalSettings->exceptionPreset().isEmpty()) {
+            if (!m_presetsConfig) {
+                KSharedConfigPtr presetsConfig = KSharedConfig::openConfig(QStringLiteral("klassy/windecopresetsrc"));
+                m_presetsConfig.swap(presetsConfig);
             }
-            if (internalSettings->opaqueTitleBar()) {
-                internalSettings->setProperty("noCacheException", true);
+            if (!m_presetsConfig) {
+                return internalSettings;
             }
-            return internalSettings;
+
+            PresetsModel::loadPreset(internalSettings.data(), m_presetsConfig.data(), internalSettings->exceptionPreset());
+            internalSettings->setProperty("noCacheException",
+                                          true); // this property is to indicate not to cache shadows or colours for an exception with a Preset
+                                                 // -- this is because the Preset exception can alter shadows and colours
+        }
+        if (internalSettings->opaqueTitleBar()) {
+            internalSettings->setProperty("noCacheException", true);
         }
+        return internalSettings;
     }
 
     return m_defaultSettings;
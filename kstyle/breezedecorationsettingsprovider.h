@@ -14,6 +14,7 @@
 
 #include "breeze.h"
 #include "breezesettings.h"
+#include "exceptionmatcher.h"
 
 #include <KSharedConfig>
 #include <QMainWindow>
@@ -51,6 +52,9 @@ private:
     //* exceptions
     InternalSettingsList m_exceptions;
 
+    //* compiled program name patterns of m_exceptions
+    ExceptionMatcher m_exceptionMatcher;
+
     //* config object
     KSharedConfigPtr m_config;
 
@@ -14,7 +14,9 @@
 #include "breeze.h"
 #include "breezedecorationsettingsprovider.h"
 #include "breezepropertynames.h"
+#include "geometrytools.h"
 #include "renderdecorationbuttonicon.h"
+#include "shareddecorationcolors.h"
 #include "systemicontheme.h"
 
 #include <KColorScheme>
@@ -90,10 +92,11 @@ void Helper::loadConfig()
     _decorationConfig = DecorationSettingsProvider::self()->internalSettings();
 
     const QString colorSchemePath = qApp->property("KDE_COLOR_SCHEME_PATH").toString();
-    // bool isApplicationSpecificColorScheme = (!colorSchemePath.isEmpty() && colorSchemePath != QStringLiteral("kdeglobals"));
+    const bool isApplicationSpecificColorScheme = (!colorSchemePath.isEmpty() && colorSchemePath != QStringLiteral("kdeglobals"));
 
-    // bool noCache = _decorationConfig->property("noCacheException").toBool() || isApplicationSpecificColorScheme;
-    bool noCache = true; // cannot easily cache between applications. TODO: reimplement with shared memory and re-enable
+    // colours are shared between applications through SharedDecorationColors rather than the in-process DecorationColors cache
+    bool noCache = true;
+    const bool useSharedColors = !(_decorationConfig->property("noCacheException").toBool() || isApplicationSpecificColorScheme);
 
     if (noCache) {
         if (!_decorationColors || _decorationColors->isCachedPalette()) {
@@ -133,13 +136,34 @@ void Helper::loadConfig()
                                                    _systemInactiveTitleBarTextColor,
                                                    colorSchemePath);
 
-        _decorationColors->generateDecorationColors(palette,
-                                                    _decorationConfig,
-                                                    _systemActiveTitleBarTextColor,
-                                                    _systemActiveTitleBarColor,
-                                                    _systemInactiveTitleBarTextColor,
-                                                    _systemInactiveTitleBarColor,
-                                                    _generateDecorationColorsOnDecorationColorSettingsUpdateUuid);
+        // another application may already have generated the colours from the same inputs
+        QByteArray sharedColorsKey;
+        DecorationPaletteGroup sharedActive;
+        DecorationPaletteGroup sharedInactive;
+        if (useSharedColors) {
+            sharedColorsKey = SharedDecorationColors::key(palette,
+                                                          _decorationConfig,
+                                                          _systemActiveTitleBarTextColor,
+                                                          _systemActiveTitleBarColor,
+                                                          _systemInactiveTitleBarTextColor,
+                                                          _systemInactiveTitleBarColor,
+                                                          colorSchemePath);
+        }
+
+        if (useSharedColors && SharedDecorationColors::load(sharedColorsKey, sharedActive, sharedInactive)) {
+            _decorationColors->setDecorationColors(palette, sharedActive, sharedInactive);
+        } else {
+            _decorationColors->generateDecorationColors(palette,
+                                                        _decorationConfig,
+                                                        _systemActiveTitleBarTextColor,
+                                                        _systemActiveTitleBarColor,
+                                                        _systemInactiveTitleBarTextColor,
+                                                        _systemInactiveTitleBarColor,
+                                                        _generateDecorationColorsOnDecorationColorSettingsUpdateUuid);
+            if (useSharedColors) {
+                SharedDecorationColors::store(sharedColorsKey, *_decorationColors->active(), *_decorationColors->inactive());
+            }
+        }
         _generateDecorationColorsOnDecorationColorSettingsUpdateUuid = "";
     }
 
@@ -667,9 +691,8 @@ QRegion Helper::menuFrameRegion(const QMenu *widget)
         frameRect = strokedRect(frameRect);
         radius = frameRadiusForNewPenWidth(radius, PenWidth::Frame);
 
-        QPainterPath path;
-        path.addRoundedRect(frameRect, radius, radius);
-        return QRegion(path.toFillPolygon().toPolygon()).intersected(widget->rect());
+        // the arc is sampled at the centre of each pixel row, so the outermost anti-aliased pixels of the corners may fall just outside the mask
+        return GeometryTools::roundedRegion(frameRect.toAlignedRect(), AllCorners, radius).intersected(widget->rect());
     }
 
     return QRegion(widget->rect());
@@ -12,10 +12,12 @@
 #include "breezemetrics.h"
 #include "breezepropertynames.h"
 #include "breezesettings.h"
+#include "shadowdiskcache.h"
 
 #include <KWindowSystem>
 
 #include <QApplication>
+#include <QDataStream>
 #include <QDockWidget>
 #include <QEvent>
 #include <QMenu>
@@ -205,6 +207,19 @@ TileSet ShadowHelper::shadowTiles(QWidget *widget)
 
     const qreal frameRadius = _helper->frameRadius();
 
+    // look for a texture already rendered by this or another application
+    QByteArray diskCacheKey;
+    QDataStream keyStream(&diskCacheKey, QIODevice::WriteOnly);
+    keyStream << QByteArrayLiteral("style") << params.offset << params.shadow1.offset << params.shadow1.radius << params.shadow1.opacity << params.shadow2.offset
+              << params.shadow2.radius << params.shadow2.opacity << dpr << color << strength << frameRadius << int(Metrics::Shadow_Overlap);
+
+    const QImage cachedTexture = ShadowDiskCache::load(diskCacheKey);
+    if (!cachedTexture.isNull()) {
+        const QPoint innerRectTopLeft = cachedTexture.rect().center();
+        _shadowTiles = TileSet(QPixmap::fromImage(cachedTexture), innerRectTopLeft.x(), innerRectTopLeft.y(), 1, 1);
+        return _shadowTiles;
+    }
+
     BoxShadowRenderer shadowRenderer;
     shadowRenderer.setBorderRadius(frameRadius);
     shadowRenderer.setBoxSize(boxSize);
@@ -236,6 +251,8 @@ TileSet ShadowHelper::shadowTiles(QWidget *widget)
     // We're done.
     painter.end();
 
+    ShadowDiskCache::store(diskCacheKey, shadowTexture);
+
     const QPoint innerRectTopLeft = outerRect.center();
     _shadowTiles = TileSet(QPixmap::fromImage(std::move(shadowTexture)), innerRectTopLeft.x(), innerRectTopLeft.y(), 1, 1);
 
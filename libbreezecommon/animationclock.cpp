@@ -0,0 +1,137 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Paul A McAuley <kde@paulmcauley.com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "animationclock.h"
+
+namespace Breeze
+{
+
+//________________________________________________________________
+AnimationClock &AnimationClock::self()
+{
+    static AnimationClock s_self;
+    return s_self;
+}
+
+//________________________________________________________________
+AnimationClock::AnimationClock()
+{
+    m_elapsedTimer.start();
+    m_timer.setInterval(s_frameInterval);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &AnimationClock::tick);
+}
+
+//________________________________________________________________
+void AnimationClock::registerAnimation(ClockedAnimation *animation)
+{
+    if (m_animations.contains(animation)) {
+        return;
+    }
+    m_animations.append(animation);
+    if (!m_timer.isActive()) {
+        m_timer.start();
+    }
+}
+
+//________________________________________________________________
+void AnimationClock::unregisterAnimation(ClockedAnimation *animation)
+{
+    m_animations.removeOne(animation);
+    if (m_animations.isEmpty()) {
+        m_timer.stop();
+    }
+}
+
+//________________________________________________________________
+void AnimationClock::tick()
+{
+    const qint64 now = this->now();
+
+    // iterate over a copy, as value changes may start or stop other animations
+    const QList<ClockedAnimation *> animations = m_animations;
+    for (ClockedAnimation *animation : animations) {
+        if (!m_animations.contains(animation)) {
+            continue;
+        }
+        if (!animation->advance(now)) {
+            unregisterAnimation(animation);
+            animation->m_state = QAbstractAnimation::Stopped;
+            Q_EMIT animation->finished();
+        }
+    }
+}
+
+//________________________________________________________________
+ClockedAnimation::ClockedAnimation(QObject *parent)
+    : QObject(parent)
+{
+}
+
+//________________________________________________________________
+ClockedAnimation::~ClockedAnimation()
+{
+    if (m_state == QAbstractAnimation::Running) {
+        AnimationClock::self().unregisterAnimation(this);
+    }
+}
+
+//________________________________________________________________
+qreal ClockedAnimation::currentValue() const
+{
+    const qreal progress = m_duration > 0 ? m_currentTime / m_duration : (m_direction == QAbstractAnimation::Forward ? 1 : 0);
+    return m_startValue + (m_endValue - m_startValue) * m_easingCurve.valueForProgress(progress);
+}
+
+//________________________________________________________________
+void ClockedAnimation::start()
+{
+    stop();
+
+    if (m_duration <= 0) {
+        m_currentTime = m_direction == QAbstractAnimation::Forward ? m_duration : 0;
+        Q_EMIT valueChanged(currentValue());
+        Q_EMIT finished();
+        return;
+    }
+
+    m_currentTime = m_direction == QAbstractAnimation::Forward ? 0 : m_duration;
+    m_lastTickTime = AnimationClock::self().now();
+    m_state = QAbstractAnimation::Running;
+    AnimationClock::self().registerAnimation(this);
+    Q_EMIT valueChanged(currentValue());
+}
+
+//________________________________________________________________
+void ClockedAnimation::stop()
+{
+    if (m_state != QAbstractAnimation::Running) {
+        return;
+    }
+    AnimationClock::self().unregisterAnimation(this);
+    m_state = QAbstractAnimation::Stopped;
+}
+
+//________________________________________________________________
+bool ClockedAnimation::advance(qint64 now)
+{
+    const qint64 elapsed = now - m_lastTickTime;
+    m_lastTickTime = now;
+
+    bool running;
+    if (m_direction == QAbstractAnimation::Forward) {
+        m_currentTime = qMin(qreal(m_duration), m_currentTime + elapsed);
+        running = m_currentTime < m_duration;
+    } else {
+        m_currentTime = qMax(qreal(0), m_currentTime - elapsed);
+        running = m_currentTime > 0;
+    }
+
+    Q_EMIT valueChanged(currentValue());
+    return running;
+}
+
+}
@@ -0,0 +1,147 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Paul A McAuley <kde@paulmcauley.com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#pragma once
+
+#include "breezecommon_export.h"
+
+#include <QAbstractAnimation>
+#include <QEasingCurve>
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QTimer>
+
+namespace Breeze
+{
+
+class ClockedAnimation;
+
+/**
+ * @brief One timer shared by every ClockedAnimation in the process.
+ *        All running animations are advanced together once per frame, so that the repaints they request are made in the same event loop iteration and
+ *        coalesced into a single paint pass, instead of each animation waking up on its own timer.
+ */
+class BREEZECOMMON_EXPORT AnimationClock : public QObject
+{
+    Q_OBJECT
+
+public:
+    //* singleton
+    static AnimationClock &self();
+
+    //* milliseconds since the clock was created
+    qint64 now() const
+    {
+        return m_elapsedTimer.elapsed();
+    }
+
+    //* add a running animation; the clock runs while any are registered
+    void registerAnimation(ClockedAnimation *animation);
+
+    //* remove an animation which has stopped or is being destroyed
+    void unregisterAnimation(ClockedAnimation *animation);
+
+private Q_SLOTS:
+    void tick();
+
+private:
+    AnimationClock();
+
+    QTimer m_timer;
+    QElapsedTimer m_elapsedTimer;
+    QList<ClockedAnimation *> m_animations;
+
+    //* about 60 frames per second, as with Qt's default animation driver
+    static constexpr int s_frameInterval = 16;
+};
+
+/**
+ * @brief A qreal-valued animation between startValue() and endValue(), driven by AnimationClock.
+ *        Provides the subset of the QVariantAnimation interface used by the decoration, but emits valueChanged() with an unboxed qreal.
+ */
+class BREEZECOMMON_EXPORT ClockedAnimation : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ClockedAnimation(QObject *parent = nullptr);
+    ~ClockedAnimation() override;
+
+    void setStartValue(qreal value)
+    {
+        m_startValue = value;
+    }
+
+    void setEndValue(qreal value)
+    {
+        m_endValue = value;
+    }
+
+    void setEasingCurve(const QEasingCurve &easingCurve)
+    {
+        m_easingCurve = easingCurve;
+    }
+
+    int duration() const
+    {
+        return m_duration;
+    }
+
+    void setDuration(int duration)
+    {
+        m_duration = duration;
+    }
+
+    QAbstractAnimation::Direction direction() const
+    {
+        return m_direction;
+    }
+
+    //* may be changed while running, in which case the animation reverses from its current position
+    void setDirection(QAbstractAnimation::Direction direction)
+    {
+        m_direction = direction;
+    }
+
+    QAbstractAnimation::State state() const
+    {
+        return m_state;
+    }
+
+    //* eased value at the current time
+    qreal currentValue() const;
+
+    //* start from the beginning of the current direction
+    void start();
+
+    //* stop at the current position
+    void stop();
+
+Q_SIGNALS:
+    void valueChanged(qreal value);
+    void finished();
+
+private:
+    friend class AnimationClock;
+
+    //* advance by the time elapsed since the last tick; returns false once finished
+    bool advance(qint64 now);
+
+    qreal m_startValue = 0;
+    qreal m_endValue = 1;
+    QEasingCurve m_easingCurve;
+    int m_duration = 250;
+    QAbstractAnimation::Direction m_direction = QAbstractAnimation::Forward;
+    QAbstractAnimation::State m_state = QAbstractAnimation::Stopped;
+
+    //* position within the duration, in ms
+    qreal m_currentTime = 0;
+    //* clock time of the last advance
+    qint64 m_lastTickTime = 0;
+};
+
+}
@@ -0,0 +1,316 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Paul A McAuley <kde@paulmcauley.com>
+ *
+ * The box blur implementation is based on AlphaBoxBlur from Firefox.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+// own
+#include "breezeboxblur.h"
+
+#include <algorithm>
+#include <vector>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__) && defined(__GNUC__)
+#define BREEZE_BOXBLUR_X86 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#define BREEZE_BOXBLUR_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace Breeze
+{
+
+namespace BoxBlur
+{
+
+/*
+ * Each box filter pass runs along the columns of a plane, so that a whole row
+ * of running sums is updated per output row. This gives contiguous loads and
+ * stores which vectorise across columns, and streams the plane in memory order.
+ * The horizontal blur is done by transposing the plane first.
+ *
+ * For every column, output row y is the mean of input rows [y - left, y + right],
+ * with rows outside the plane clamped to the first and last rows:
+ *
+ *     out = ((sum + (boxSize + 1) / 2) * ((1 << 24) / boxSize)) >> 24
+ *
+ * This is exactly the arithmetic of the original scalar row filter, so every
+ * kernel produces bit-identical results.
+ */
+
+//* scalar kernel, also used for the columns left over by the vector kernels
+struct ScalarKernel {
+    static void accumulate(uint32_t *sums, const uint8_t *row, int count)
+    {
+        for (int x = 0; x < count; ++x) {
+            sums[x] += row[x];
+        }
+    }
+
+    static void outputAndSlide(uint32_t *sums, uint8_t *out, const uint8_t *enter, const uint8_t *leave, int count, uint32_t reciprocal)
+    {
+        for (int x = 0; x < count; ++x) {
+            out[x] = (sums[x] * reciprocal) >> 24;
+            sums[x] += enter[x] - leave[x];
+        }
+    }
+};
+
+#if BREEZE_BOXBLUR_X86
+//* SSE2 kernel, 16 columns at a time
+struct Sse2Kernel {
+    static void accumulate(uint32_t *sums, const uint8_t *row, int count)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        int x = 0;
+        for (; x + 16 <= count; x += 16) {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x));
+            const __m128i words[2] = {_mm_unpacklo_epi8(bytes, zero), _mm_unpackhi_epi8(bytes, zero)};
+            for (int i = 0; i < 4; ++i) {
+                __m128i *s = reinterpret_cast<__m128i *>(sums + x + 4 * i);
+                const __m128i values = (i % 2) ? _mm_unpackhi_epi16(words[i / 2], zero) : _mm_unpacklo_epi16(words[i / 2], zero);
+                _mm_storeu_si128(s, _mm_add_epi32(_mm_loadu_si128(s), values));
+            }
+        }
+        ScalarKernel::accumulate(sums + x, row + x, count - x);
+    }
+
+    static inline __m128i divide(__m128i sum, __m128i reciprocal)
+    {
+        // SSE2 has no 32-bit low multiply, so multiply even and odd lanes separately as 64-bit products.
+        // The products never exceed 32 bits, so the results fit in the low halves.
+        const __m128i even = _mm_srli_epi64(_mm_mul_epu32(sum, reciprocal), 24);
+        const __m128i odd = _mm_srli_epi64(_mm_mul_epu32(_mm_srli_epi64(sum, 32), reciprocal), 24);
+        return _mm_or_si128(even, _mm_slli_epi64(odd, 32));
+    }
+
+    static void outputAndSlide(uint32_t *sums, uint8_t *out, const uint8_t *enter, const uint8_t *leave, int count, uint32_t reciprocal)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i reciprocalVector = _mm_set1_epi32(reciprocal);
+        int x = 0;
+        for (; x + 16 <= count; x += 16) {
+            const __m128i enterBytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(enter + x));
+            const __m128i leaveBytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(leave + x));
+            const __m128i enterWords[2] = {_mm_unpacklo_epi8(enterBytes, zero), _mm_unpackhi_epi8(enterBytes, zero)};
+            const __m128i leaveWords[2] = {_mm_unpacklo_epi8(leaveBytes, zero), _mm_unpackhi_epi8(leaveBytes, zero)};
+
+            __m128i results[4];
+            for (int i = 0; i < 4; ++i) {
+                __m128i *s = reinterpret_cast<__m128i *>(sums + x + 4 * i);
+                __m128i sum = _mm_loadu_si128(s);
+                results[i] = divide(sum, reciprocalVector);
+
+                const __m128i enterValues = (i % 2) ? _mm_unpackhi_epi16(enterWords[i / 2], zero) : _mm_unpacklo_epi16(enterWords[i / 2], zero);
+                const __m128i leaveValues = (i % 2) ? _mm_unpackhi_epi16(leaveWords[i / 2], zero) : _mm_unpacklo_epi16(leaveWords[i / 2], zero);
+                sum = _mm_sub_epi32(_mm_add_epi32(sum, enterValues), leaveValues);
+                _mm_storeu_si128(s, sum);
+            }
+
+            // results are at most 255, so saturating packs are exact
+            const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(results[0], results[1]), _mm_packs_epi32(results[2], results[3]));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x), packed);
+        }
+        ScalarKernel::outputAndSlide(sums + x, out + x, enter + x, leave + x, count - x, reciprocal);
+    }
+};
+
+//* AVX2 kernel, 16 columns at a time
+struct Avx2Kernel {
+    __attribute__((target("avx2"))) static void accumulate(uint32_t *sums, const uint8_t *row, int count)
+    {
+        int x = 0;
+        for (; x + 16 <= count; x += 16) {
+            for (int i = 0; i < 2; ++i) {
+                __m256i *s = reinterpret_cast<__m256i *>(sums + x + 8 * i);
+                const __m256i values = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(row + x + 8 * i)));
+                _mm256_storeu_si256(s, _mm256_add_epi32(_mm256_loadu_si256(s), values));
+            }
+        }
+        ScalarKernel::accumulate(sums + x, row + x, count - x);
+    }
+
+    __attribute__((target("avx2"))) static void
+    outputAndSlide(uint32_t *sums, uint8_t *out, const uint8_t *enter, const uint8_t *leave, int count, uint32_t reciprocal)
+    {
+        const __m256i reciprocalVector = _mm256_set1_epi32(reciprocal);
+        int x = 0;
+        for (; x + 16 <= count; x += 16) {
+            __m256i results[2];
+            for (int i = 0; i < 2; ++i) {
+                __m256i *s = reinterpret_cast<__m256i *>(sums + x + 8 * i);
+                __m256i sum = _mm256_loadu_si256(s);
+                results[i] = _mm256_srli_epi32(_mm256_mullo_epi32(sum, reciprocalVector), 24);
+
+                const __m256i enterValues = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(enter + x + 8 * i)));
+                const __m256i leaveValues = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(leave + x + 8 * i)));
+                sum = _mm256_sub_epi32(_mm256_add_epi32(sum, enterValues), leaveValues);
+                _mm256_storeu_si256(s, sum);
+            }
+
+            // packs operate within 128-bit lanes, so restore column order before the final pack
+            const __m256i words = _mm256_permute4x64_epi64(_mm256_packus_epi32(results[0], results[1]), 0xd8);
+            const __m128i packed = _mm_packus_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x), packed);
+        }
+        ScalarKernel::outputAndSlide(sums + x, out + x, enter + x, leave + x, count - x, reciprocal);
+    }
+};
+#endif
+
+#if BREEZE_BOXBLUR_NEON
+//* NEON kernel, 16 columns at a time
+struct NeonKernel {
+    static void accumulate(uint32_t *sums, const uint8_t *row, int count)
+    {
+        int x = 0;
+        for (; x + 16 <= count; x += 16) {
+            const uint8x16_t bytes = vld1q_u8(row + x);
+            const uint16x8_t words[2] = {vmovl_u8(vget_low_u8(bytes)), vmovl_u8(vget_high_u8(bytes))};
+            for (int i = 0; i < 4; ++i) {
+                uint32_t *s = sums + x + 4 * i;
+                const uint16x4_t values = (i % 2) ? vget_high_u16(words[i / 2]) : vget_low_u16(words[i / 2]);
+                vst1q_u32(s, vaddw_u16(vld1q_u32(s), values));
+            }
+        }
+        ScalarKernel::accumulate(sums + x, row + x, count - x);
+    }
+
+    static void outputAndSlide(uint32_t *sums, uint8_t *out, const uint8_t *enter, const uint8_t *leave, int count, uint32_t reciprocal)
+    {
+        const uint32x4_t reciprocalVector = vdupq_n_u32(reciprocal);
+        int x = 0;
+        for (; x + 16 <= count; x += 16) {
+            const uint8x16_t enterBytes = vld1q_u8(enter + x);
+            const uint8x16_t leaveBytes = vld1q_u8(leave + x);
+            const uint16x8_t enterWords[2] = {vmovl_u8(vget_low_u8(enterBytes)), vmovl_u8(vget_high_u8(enterBytes))};
+            const uint16x8_t leaveWords[2] = {vmovl_u8(vget_low_u8(leaveBytes)), vmovl_u8(vget_high_u8(leaveBytes))};
+
+            uint16x4_t results[4];
+            for (int i = 0; i < 4; ++i) {
+                uint32_t *s = sums + x + 4 * i;
+                uint32x4_t sum = vld1q_u32(s);
+                results[i] = vmovn_u32(vshrq_n_u32(vmulq_u32(sum, reciprocalVector), 24));
+
+                const uint16x4_t enterValues = (i % 2) ? vget_high_u16(enterWords[i / 2]) : vget_low_u16(enterWords[i / 2]);
+                const uint16x4_t leaveValues = (i % 2) ? vget_high_u16(leaveWords[i / 2]) : vget_low_u16(leaveWords[i / 2]);
+                sum = vsubw_u16(vaddw_u16(sum, enterValues), leaveValues);
+                vst1q_u32(s, sum);
+            }
+
+            const uint8x16_t packed =
+                vcombine_u8(vmovn_u16(vcombine_u16(results[0], results[1])), vmovn_u16(vcombine_u16(results[2], results[3])));
+            vst1q_u8(out + x, packed);
+        }
+        ScalarKernel::outputAndSlide(sums + x, out + x, enter + x, leave + x, count - x, reciprocal);
+    }
+};
+#endif
+
+/**
+ * Run a box filter along the columns of a plane.
+ *
+ * @param src The input plane.
+ * @param dst The output plane, which must not overlap the input.
+ * @param columns The number of columns.
+ * @param rows The number of rows, i.e. the length of the filtered direction.
+ * @param lobes Params of the box filter.
+ * @param sums Scratch space for one running sum per column.
+ **/
+template<typename Kernel>
+static void boxBlurColumns(const uint8_t *src, int srcStride, uint8_t *dst, int dstStride, int columns, int rows, const BoxLobes &lobes, uint32_t *sums)
+{
+    const int boxSize = lobes.left + 1 + lobes.right;
+    const uint32_t reciprocal = (1 << 24) / boxSize;
+
+    // the window for the first output row: the first row repeated left times, and rows 0 to right
+    for (int x = 0; x < columns; ++x) {
+        sums[x] = (boxSize + 1) / 2 + src[x] * lobes.left;
+    }
+    for (int y = 0; y <= lobes.right; ++y) {
+        Kernel::accumulate(sums, src + std::min(y, rows - 1) * srcStride, columns);
+    }
+
+    for (int y = 0; y < rows; ++y) {
+        const uint8_t *enter = src + std::min(y + lobes.right + 1, rows - 1) * srcStride;
+        const uint8_t *leave = src + std::max(y - lobes.left, 0) * srcStride;
+        Kernel::outputAndSlide(sums, dst + y * dstStride, enter, leave, columns, reciprocal);
+    }
+}
+
+/**
+ * Transpose a plane, in cache-sized blocks.
+ **/
+static void transpose(const uint8_t *src, int srcStride, uint8_t *dst, int dstStride, int rows, int columns)
+{
+    constexpr int blockSize = 32;
+
+    for (int blockY = 0; blockY < rows; blockY += blockSize) {
+        const int endY = std::min(blockY + blockSize, rows);
+        for (int blockX = 0; blockX < columns; blockX += blockSize) {
+            const int endX = std::min(blockX + blockSize, columns);
+            for (int y = blockY; y < endY; ++y) {
+                const uint8_t *in = src + y * srcStride;
+                for (int x = blockX; x < endX; ++x) {
+                    dst[x * dstStride + y] = in[x];
+                }
+            }
+        }
+    }
+}
+
+template<typename Kernel>
+static void blurPlaneWithKernel(uint8_t *plane, int width, int height, int stride, const BoxLobes lobes[3])
+{
+    const size_t size = size_t(width) * height;
+    std::vector<uint8_t> transposed(size);
+    std::vector<uint8_t> buffer1(size);
+    std::vector<uint8_t> buffer2(size);
+    std::vector<uint32_t> sums(std::max(width, height));
+
+    // Blur the image in horizontal direction, as columns of the transposed plane.
+    transpose(plane, stride, transposed.data(), height, height, width);
+    boxBlurColumns<Kernel>(transposed.data(), height, buffer1.data(), height, height, width, lobes[0], sums.data());
+    boxBlurColumns<Kernel>(buffer1.data(), height, buffer2.data(), height, height, width, lobes[1], sums.data());
+    boxBlurColumns<Kernel>(buffer2.data(), height, transposed.data(), height, height, width, lobes[2], sums.data());
+    transpose(transposed.data(), height, plane, stride, width, height);
+
+    // Blur the image in vertical direction.
+    boxBlurColumns<Kernel>(plane, stride, buffer1.data(), width, width, height, lobes[0], sums.data());
+    boxBlurColumns<Kernel>(buffer1.data(), width, buffer2.data(), width, width, height, lobes[1], sums.data());
+    boxBlurColumns<Kernel>(buffer2.data(), width, plane, stride, width, height, lobes[2], sums.data());
+}
+
+using BlurPlaneFunction = void (*)(uint8_t *, int, int, int, const BoxLobes[3]);
+
+static BlurPlaneFunction selectBlurPlaneFunction()
+{
+#if BREEZE_BOXBLUR_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return blurPlaneWithKernel<Avx2Kernel>;
+    }
+    return blurPlaneWithKernel<Sse2Kernel>;
+#elif BREEZE_BOXBLUR_NEON
+    return blurPlaneWithKernel<NeonKernel>;
+#else
+    return blurPlaneWithKernel<ScalarKernel>;
+#endif
+}
+
+void blurPlane(uint8_t *plane, int width, int height, int stride, const BoxLobes lobes[3])
+{
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+
+    static const BlurPlaneFunction blurPlaneFunction = selectBlurPlaneFunction();
+    blurPlaneFunction(plane, width, height, stride, lobes);
+}
+
+} // namespace BoxBlur
+
+} // namespace Breeze
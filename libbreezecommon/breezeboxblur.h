@@ -0,0 +1,39 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Paul A McAuley <kde@paulmcauley.com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace Breeze
+{
+
+struct BoxLobes {
+    int left; ///< how many pixels sample to the left
+    int right; ///< how many pixels sample to the right
+};
+
+namespace BoxBlur
+{
+
+/**
+ * Blur an 8-bit plane in place with three successive box filters, first
+ * horizontally and then vertically.
+ *
+ * Uses SSE2/AVX2 on x86 and NEON on ARM when available, selected at runtime,
+ * with a portable scalar fallback. All implementations give identical output.
+ *
+ * @param plane The first byte of the plane.
+ * @param width The width of the plane, in pixels.
+ * @param height The height of the plane, in pixels.
+ * @param stride The number of bytes from one row to the next row.
+ * @param lobes Params of the three box filters.
+ **/
+void blurPlane(uint8_t *plane, int width, int height, int stride, const BoxLobes lobes[3]);
+
+} // namespace BoxBlur
+
+} // namespace Breeze
@@ -17,6 +17,7 @@
 
 // own
 #include "breezeboxshadowrenderer.h"
+#include "breezeboxblur.h"
 
 // Qt
 #include <QPainter>
@@ -44,11 +45,6 @@ static inline QSize calculateBlurExtent(int radius)
     return QSize(blurRadius, blurRadius);
 }
 
-struct BoxLobes {
-    int left; ///< how many pixels sample to the left
-    int right; ///< how many pixels sample to the right
-};
-
 /**
  * Compute box filter parameters.
  *
@@ -92,77 +88,6 @@ static QVector<BoxLobes> computeLobes(int radius)
     return {{major, minor}, {minor, major}, {final, final}};
 }
 
-/**
- * Process a row with a box filter.
- *
- * @param src The start of the row.
- * @param dst The destination.
- * @param width The width of the row, in pixels.
- * @param horizontalStride The number of bytes from one alpha value to the
- *    next alpha value.
- * @param verticalStride The number of bytes from one row to the next row.
- * @param lobes Params of the box filter.
- * @param transposeInput Whether the input is transposed.
- * @param transposeOutput Whether the output should be transposed.
- **/
-static inline void boxBlurRowAlpha(const uint8_t *src,
-                                   uint8_t *dst,
-                                   int width,
-                                   int horizontalStride,
-                                   int verticalStride,
-                                   const BoxLobes &lobes,
-                                   bool transposeInput,
-                                   bool transposeOutput)
-{
-    const int inputStep = transposeInput ? verticalStride : horizontalStride;
-    const int outputStep = transposeOutput ? verticalStride : horizontalStride;
-
-    const int boxSize = lobes.left + 1 + lobes.right;
-    const int reciprocal = (1 << 24) / boxSize;
-
-    uint32_t alphaSum = (boxSize + 1) / 2;
-
-    const uint8_t *left = src;
-    const uint8_t *right = src;
-    uint8_t *out = dst;
-
-    const uint8_t firstValue = src[0];
-    const uint8_t lastValue = src[(width - 1) * inputStep];
-
-    alphaSum += firstValue * lobes.left;
-
-    const uint8_t *initEnd = src + (boxSize - lobes.left) * inputStep;
-    while (right < initEnd) {
-        alphaSum += *right;
-        right += inputStep;
-    }
-
-    const uint8_t *leftEnd = src + boxSize * inputStep;
-    while (right < leftEnd) {
-        *out = (alphaSum * reciprocal) >> 24;
-        alphaSum += *right - firstValue;
-        right += inputStep;
-        out += outputStep;
-    }
-
-    const uint8_t *centerEnd = src + width * inputStep;
-    while (right < centerEnd) {
-        *out = (alphaSum * reciprocal) >> 24;
-        alphaSum += *right - *left;
-        left += inputStep;
-        right += inputStep;
-        out += outputStep;
-    }
-
-    const uint8_t *rightEnd = dst + width * outputStep;
-    while (out < rightEnd) {
-        *out = (alphaSum * reciprocal) >> 24;
-        alphaSum += lastValue - *left;
-        left += inputStep;
-        out += outputStep;
-    }
-}
-
 /**
  * Blur the alpha channel of a given image.
  *
@@ -184,28 +109,27 @@ static inline void boxBlurAlpha(QImage &image, int radius, const QRect &rect = {
     const int alphaOffset = QSysInfo::ByteOrder == QSysInfo::BigEndian ? 0 : 3;
     const int width = blurRect.width();
     const int height = blurRect.height();
-    const int rowStride = image.bytesPerLine();
     const int pixelStride = image.depth() >> 3;
 
-    const int bufferStride = qMax(width, height) * pixelStride;
-    QScopedPointer<uint8_t, QScopedPointerArrayDeleter<uint8_t>> buf(new uint8_t[2 * bufferStride]);
-    uint8_t *buf1 = buf.data();
-    uint8_t *buf2 = buf1 + bufferStride;
+    // Gather the alpha channel into a tightly packed plane, so the blur can be vectorised.
+    QScopedPointer<uint8_t, QScopedPointerArrayDeleter<uint8_t>> plane(new uint8_t[width * height]);
 
-    // Blur the image in horizontal direction.
     for (int i = 0; i < height; ++i) {
-        uint8_t *row = image.scanLine(blurRect.y() + i) + blurRect.x() * pixelStride + alphaOffset;
-        boxBlurRowAlpha(row, buf1, width, pixelStride, rowStride, lobes[0], false, false);
-        boxBlurRowAlpha(buf1, buf2, width, pixelStride, rowStride, lobes[1], false, false);
-        boxBlurRowAlpha(buf2, row, width, pixelStride, rowStride, lobes[2], false, false);
+        const uint8_t *in = image.constScanLine(blurRect.y() + i) + blurRect.x() * pixelStride + alphaOffset;
+        uint8_t *out = plane.data() + i * width;
+        for (int j = 0; j < width; ++j, in += pixelStride) {
+            out[j] = *in;
+        }
     }
 
-    // Blur the image in vertical direction.
-    for (int i = 0; i < width; ++i) {
-        uint8_t *column = image.scanLine(blurRect.y()) + (blurRect.x() + i) * pixelStride + alphaOffset;
-        boxBlurRowAlpha(column, buf1, height, pixelStride, rowStride, lobes[0], true, false);
-        boxBlurRowAlpha(buf1, buf2, height, pixelStride, rowStride, lobes[1], false, false);
-        boxBlurRowAlpha(buf2, column, height, pixelStride, rowStride, lobes[2], false, true);
+    BoxBlur::blurPlane(plane.data(), width, height, width, lobes.constData());
+
+    for (int i = 0; i < height; ++i) {
+        const uint8_t *in = plane.data() + i * width;
+        uint8_t *out = image.scanLine(blurRect.y() + i) + blurRect.x() * pixelStride + alphaOffset;
+        for (int j = 0; j < width; ++j, out += pixelStride) {
+            *out = in[j];
+        }
     }
 }
 
@@ -239,13 +163,17 @@ static inline void mirrorTopLeftQuadrant(QImage &image)
     }
 }
 
-static void renderShadow(QPainter *painter, const QRect &rect, qreal borderRadius, const QPoint &offset, int radius, const QColor &color)
+/**
+ * Render the blurred, untinted shape of a shadow.
+ *
+ * @returns An image whose alpha channel holds the blurred box, and the rect,
+ *    relative to the painter, at which it should be drawn.
+ **/
+static QImage renderBlurredBox(const QRect &rect, qreal borderRadius, const QPoint &offset, int radius, qreal dpr, QRect &shadowRect)
 {
     const QSize inflation = calculateBlurExtent(radius);
     const QSize size = rect.size() + 2 * inflation;
 
-    const qreal dpr = painter->device()->devicePixelRatioF();
-
     QImage shadow(size * dpr, QImage::Format_ARGB32_Premultiplied);
     shadow.setDevicePixelRatio(dpr);
     shadow.fill(Qt::transparent);
@@ -271,19 +199,41 @@ static void renderShadow(QPainter *painter, const QRect &rect, qreal borderRadiu
     boxBlurAlpha(shadow, scaledRadius, blurRect);
     mirrorTopLeftQuadrant(shadow);
 
+    shadowRect = shadow.rect();
+    shadowRect.setSize(shadowRect.size() / dpr);
+    shadowRect.moveCenter(rect.center() + offset);
+
+    return shadow;
+}
+
+static void renderShadow(QPainter *painter, const QRect &rect, qreal borderRadius, const QPoint &offset, int radius, const QColor &color)
+{
+    QRect shadowRect;
+    QImage shadow = renderBlurredBox(rect, borderRadius, offset, radius, painter->device()->devicePixelRatioF(), shadowRect);
+
     // Give the shadow a tint of the desired color.
+    QPainter shadowPainter;
     shadowPainter.begin(&shadow);
     shadowPainter.setCompositionMode(QPainter::CompositionMode_SourceIn);
     shadowPainter.fillRect(shadow.rect(), color);
     shadowPainter.end();
 
     // Actually, present the shadow.
-    QRect shadowRect = shadow.rect();
-    shadowRect.setSize(shadowRect.size() / dpr);
-    shadowRect.moveCenter(rect.center() + offset);
     painter->drawImage(shadowRect, shadow);
 }
 
+/**
+ * Multiply every channel of a premultiplied pixel by an alpha value in the range 0-255.
+ **/
+static inline QRgb multiplyPixel(QRgb pixel, uint alpha)
+{
+    const auto multiply = [alpha](uint channel) {
+        const uint t = channel * alpha + 128;
+        return (t + (t >> 8)) >> 8;
+    };
+    return qRgba(multiply(qRed(pixel)), multiply(qGreen(pixel)), multiply(qBlue(pixel)), multiply(qAlpha(pixel)));
+}
+
 void BoxShadowRenderer::setBoxSize(const QSize &size)
 {
     m_boxSize = size;
@@ -329,6 +279,78 @@ QImage BoxShadowRenderer::render() const
     return canvas;
 }
 
+QVector<QImage> BoxShadowRenderer::renderMasks() const
+{
+    QVector<QImage> masks;
+    if (m_shadows.isEmpty()) {
+        return masks;
+    }
+
+    QSize canvasSize;
+    for (const Shadow &shadow : std::as_const(m_shadows)) {
+        canvasSize = canvasSize.expandedTo(calculateMinimumShadowTextureSize(m_boxSize, shadow.radius, shadow.offset));
+    }
+
+    QRect boxRect(QPoint(0, 0), m_boxSize);
+    boxRect.moveCenter(QRect(QPoint(0, 0), canvasSize).center());
+
+    masks.reserve(m_shadows.size());
+    for (const Shadow &shadow : std::as_const(m_shadows)) {
+        QImage mask(canvasSize, QImage::Format_Alpha8);
+        mask.fill(Qt::transparent);
+
+        QRect shadowRect;
+        const QImage blurredBox = renderBlurredBox(boxRect, m_borderRadius, shadow.offset, shadow.radius, 1.0, shadowRect);
+
+        QPainter painter(&mask);
+        painter.drawImage(shadowRect, blurredBox);
+        painter.end();
+
+        masks.append(mask);
+    }
+
+    return masks;
+}
+
+QImage BoxShadowRenderer::composite(const QVector<QImage> &masks, const QVector<QColor> &colors)
+{
+    Q_ASSERT(masks.size() == colors.size());
+
+    if (masks.isEmpty()) {
+        return {};
+    }
+
+    QImage canvas(masks.first().size(), QImage::Format_ARGB32_Premultiplied);
+    canvas.fill(Qt::transparent);
+
+    const int width = canvas.width();
+    const int height = canvas.height();
+
+    // Draw each tinted mask in turn with the SourceOver operator, as render() would.
+    for (int i = 0; i < masks.size(); ++i) {
+        const QRgb color = qPremultiply(colors[i].rgba());
+        if (qAlpha(color) == 0) {
+            continue;
+        }
+
+        const QImage &mask = masks[i];
+        for (int y = 0; y < height; ++y) {
+            const uint8_t *in = mask.constScanLine(y);
+            QRgb *out = reinterpret_cast<QRgb *>(canvas.scanLine(y));
+
+            for (int x = 0; x < width; ++x) {
+                if (!in[x]) {
+                    continue;
+                }
+                const QRgb source = multiplyPixel(color, in[x]);
+                out[x] = source + multiplyPixel(out[x], 255 - qAlpha(source));
+            }
+        }
+    }
+
+    return canvas;
+}
+
 QSize BoxShadowRenderer::calculateMinimumBoxSize(int radius)
 {
     const QSize blurExtent = calculateBlurExtent(radius);
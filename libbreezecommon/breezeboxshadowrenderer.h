@@ -14,6 +14,7 @@
 #include <QImage>
 #include <QPoint>
 #include <QSize>
+#include <QVector>
 
 namespace Breeze
 {
@@ -48,6 +49,23 @@ public:
      **/
     QImage render() const;
 
+    /**
+     * Render the blurred alpha mask of each shadow, without any colour.
+     *
+     * The masks only depend on the box size, the border radius and the radius and
+     * offset of each shadow, so they can be rendered once and then tinted cheaply
+     * with different colours using composite(), without repeating the blur.
+     **/
+    QVector<QImage> renderMasks() const;
+
+    /**
+     * Tint and composite shadow masks.
+     *
+     * @param masks The masks returned by renderMasks().
+     * @param colors The color of each shadow, in the order the shadows were added.
+     **/
+    static QImage composite(const QVector<QImage> &masks, const QVector<QColor> &colors);
+
     /**
      * Calculate the minimum size of the box.
      *
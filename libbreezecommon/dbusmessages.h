@@ -45,6 +45,16 @@ public:
         QDBusConnection::sessionBus().send(message);
     }
 
+    static void decorationSettingsChanges(uint changes)
+    {
+        // tells decorations which parts are affected by the following reloadConfig, as a SettingsChanges mask
+        QDBusMessage message(QDBusMessage::createSignal(QStringLiteral("/KlassyDecoration"),
+                                                        QStringLiteral("org.kde.Klassy.Style"),
+                                                        QStringLiteral("decorationSettingsChanges")));
+        message.setArguments({QVariant(changes)});
+        QDBusConnection::sessionBus().send(message);
+    }
+
     static void setGtkTheme(QString themeName)
     {
         QDBusMessage message(QDBusMessage::createMethodCall(QStringLiteral("org.kde.GtkConfig"),
@@ -31,6 +31,13 @@ DBusUpdateNotifier::DBusUpdateNotifier()
                            QStringLiteral("updateDecorationColorCache"),
                            this,
                            SLOT(onWindowDecorationSettingsUpdate()));
+
+    dBusConnection.connect(QString(),
+                           QStringLiteral("/KlassyDecoration"),
+                           QStringLiteral("org.kde.Klassy.Style"),
+                           QStringLiteral("decorationSettingsChanges"),
+                           this,
+                           SLOT(onWindowDecorationSettingsChanges(uint)));
 }
 
 void DBusUpdateNotifier::onWindowDecorationSettingsUpdate()
@@ -38,6 +45,11 @@ void DBusUpdateNotifier::onWindowDecorationSettingsUpdate()
     Q_EMIT decorationSettingsUpdate(QUuid::createUuid().toByteArray());
 }
 
+void DBusUpdateNotifier::onWindowDecorationSettingsChanges(uint changes)
+{
+    Q_EMIT decorationSettingsChanges(SettingsChanges(QFlag(int(changes))));
+}
+
 void DBusUpdateNotifier::onSystemSettingUpdate(QString first, QString second, QDBusVariant third)
 {
     Q_UNUSED(third);
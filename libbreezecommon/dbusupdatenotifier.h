@@ -8,6 +8,7 @@
 
 #include "breeze.h"
 #include "breezecommon_export.h"
+#include "settingschanges.h"
 #include <QDBusVariant>
 #include <QString>
 
@@ -23,10 +24,12 @@ public:
 
 public Q_SLOTS:
     void onWindowDecorationSettingsUpdate();
+    void onWindowDecorationSettingsChanges(uint changes);
     void onSystemSettingUpdate(QString, QString, QDBusVariant);
 
 Q_SIGNALS:
     void decorationSettingsUpdate(QByteArray uuid);
+    void decorationSettingsChanges(Breeze::SettingsChanges changes);
     void systemColorSchemeUpdate(QByteArray uuid);
     void systemIconsUpdate();
 };
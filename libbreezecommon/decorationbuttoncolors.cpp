@@ -5,6 +5,7 @@
  */
 #include "decorationbuttoncolors.h"
 #include "colortools.h"
+#include "decorationcolors.h"
 #include <KColorUtils>
 #include <QJsonArray>
 #include <QJsonDocument>
@@ -27,143 +28,359 @@ void DecorationButtonPalette::generate(InternalSettingsPtr decorationSettings,
                                        const bool generateOneGroupOnly,
                                        const bool oneGroupActiveState)
 {
-    _decorationSettings = decorationSettings;
-    _decorationColorsActive = decorationColorsActive;
-    _decorationColorsInactive = decorationColorsInactive;
+    setDecorationColors(decorationSettings,
+                        decorationColorsActive,
+                        decorationColorsInactive,
+                        ButtonOverrideColorTable::forSettings(decorationSettings.data()));
 
     if (!(generateOneGroupOnly && !oneGroupActiveState)) { // active
-        decodeButtonOverrideColors(true);
-        generateButtonBackgroundPalette(true);
-        generateButtonForegroundPalette(true);
-        generateButtonOutlinePalette(true);
+        generateGroup(true);
     }
 
     if (!(generateOneGroupOnly && oneGroupActiveState)) { // inactive
-        decodeButtonOverrideColors(false);
-        generateButtonBackgroundPalette(false);
-        generateButtonForegroundPalette(false);
-        generateButtonOutlinePalette(false);
+        generateGroup(false);
     }
 }
 
-void DecorationButtonPalette::decodeButtonOverrideColors(const bool active)
+void DecorationButtonPalette::generateAll(DecorationButtonPaletteTable &palettes,
+                                          InternalSettingsPtr decorationSettings,
+                                          const DecorationPaletteGroup *decorationColorsActive,
+                                          const DecorationPaletteGroup *decorationColorsInactive,
+                                          const bool generateOneGroupOnly,
+                                          const bool oneGroupActiveState)
 {
-    QMap<OverridableButtonColorState, QColor> &buttonOverrideColors = active ? _buttonOverrideColorsActive : _buttonOverrideColorsInactive;
-    bool &buttonOverrideColorsPresent = active ? _buttonOverrideColorsPresentActive : _buttonOverrideColorsPresentInactive;
+    ForegroundContrastCache foregroundContrastCache;
 
-    buttonOverrideColors.clear();
-    buttonOverrideColorsPresent = false;
+    // every palette shares the settings, so look up their override colour table once
+    const auto buttonOverrideColorTable = ButtonOverrideColorTable::forSettings(decorationSettings.data());
+    for (auto &palette : palettes) {
+        if (palette) {
+            palette->setDecorationColors(decorationSettings, decorationColorsActive, decorationColorsInactive, buttonOverrideColorTable);
+        }
+    }
+
+    for (const bool active : {true, false}) {
+        if (generateOneGroupOnly && active != oneGroupActiveState) {
+            continue;
+        }
 
-    bool overrideButtonTypeValid = false;
-    for (int i = 0; i < InternalSettings::EnumButtonOverrideColorsActiveButtonType::COUNT; i++) {
-        if (static_cast<int>(_buttonType) == i) {
-            overrideButtonTypeValid = true;
+        // the first palette generated without type-specific or override colours, which the others like it copy
+        const DecorationButtonPalette *commonPalette = nullptr;
+        for (auto &palette : palettes) {
+            if (!palette) {
+                continue;
+            }
+
+            const bool common = !hasTypeSpecificColors(palette->_buttonType) && !palette->_buttonOverrideColorTable->row(palette->_buttonType, active);
+            if (common && commonPalette) {
+                palette->copyGroup(*commonPalette, active);
+                continue;
+            }
+
+            palette->_foregroundContrastCache = &foregroundContrastCache;
+            palette->generateGroup(active);
+            palette->_foregroundContrastCache = nullptr;
+
+            if (common) {
+                commonPalette = &*palette;
+            }
+        }
+    }
+}
+
+bool DecorationButtonPalette::hasTypeSpecificColors(DecorationButtonType buttonType)
+{
+    return buttonType == DecorationButtonType::Close || buttonType == DecorationButtonType::Maximize || buttonType == DecorationButtonType::Minimize;
+}
+
+void DecorationButtonPalette::setDecorationColors(InternalSettingsPtr decorationSettings,
+                                                  const DecorationPaletteGroup *decorationColorsActive,
+                                                  const DecorationPaletteGroup *decorationColorsInactive,
+                                                  const std::shared_ptr<const ButtonOverrideColorTable> &buttonOverrideColorTable)
+{
+    _decorationSettings = decorationSettings;
+    _decorationColorsActive = decorationColorsActive;
+    _decorationColorsInactive = decorationColorsInactive;
+    _buttonOverrideColorTable = buttonOverrideColorTable;
+    clearRamps();
+}
+
+void DecorationButtonPalette::generateGroup(const bool active)
+{
+    resolveButtonOverrideColors(active);
+    generateButtonBackgroundPalette(active);
+    generateButtonForegroundPalette(active);
+    generateButtonOutlinePalette(active);
+}
+
+void DecorationButtonPalette::copyGroup(const DecorationButtonPalette &other, const bool active)
+{
+    resolveButtonOverrideColors(active);
+    *(active ? _active : _inactive) = *(active ? other._active : other._inactive);
+}
+
+void DecorationButtonPalette::clearRamps()
+{
+    for (auto &ramp : _activeStateRamps) {
+        ramp.clear();
+    }
+    for (auto &componentRamps : _hoverRamps) {
+        for (auto &ramp : componentRamps) {
+            ramp.clear();
+        }
+    }
+}
+
+QColor DecorationButtonPalette::groupColor(const DecorationButtonPaletteGroup *group, OverridableButtonColorState state)
+{
+    switch (state) {
+    case OverridableButtonColorState::IconNormal:
+        return group->foregroundNormal;
+    case OverridableButtonColorState::IconHover:
+        return group->foregroundHover;
+    case OverridableButtonColorState::IconPress:
+        return group->foregroundPress;
+    case OverridableButtonColorState::BackgroundNormal:
+        return group->backgroundNormal;
+    case OverridableButtonColorState::BackgroundHover:
+        return group->backgroundHover;
+    case OverridableButtonColorState::BackgroundPress:
+        return group->backgroundPress;
+    case OverridableButtonColorState::OutlineNormal:
+        return group->outlineNormal;
+    case OverridableButtonColorState::OutlineHover:
+        return group->outlineHover;
+    case OverridableButtonColorState::OutlinePress:
+        return group->outlinePress;
+    default:
+        return QColor();
+    }
+}
+
+QColor DecorationButtonPalette::activeStateRampColor(OverridableButtonColorState state, qreal activeOpacity) const
+{
+    QList<QColor> &ramp = _activeStateRamps[static_cast<int>(state)];
+    if (ramp.isEmpty()) {
+        const QColor activeColor = groupColor(_active.get(), state);
+        const QColor inactiveColor = groupColor(_inactive.get(), state);
+        ramp.reserve(s_rampSteps + 1);
+        for (int step = 0; step <= s_rampSteps; step++) {
+            const qreal opacity = qreal(step) / s_rampSteps;
+            if (activeColor.isValid() && inactiveColor.isValid()) {
+                ramp.append(KColorUtils::mix(inactiveColor, activeColor, opacity));
+            } else if (activeColor.isValid()) {
+                ramp.append(ColorTools::alphaMix(activeColor, opacity));
+            } else if (inactiveColor.isValid()) {
+                ramp.append(ColorTools::alphaMix(inactiveColor, 1.0 - opacity));
+            } else {
+                ramp.append(QColor());
+            }
+        }
+    }
+    return ramp.at(qBound(0, qRound(activeOpacity * s_rampSteps), s_rampSteps));
+}
+
+QColor DecorationButtonPalette::hoverRampColor(ButtonComponent component, const bool active, qreal hoverOpacity) const
+{
+    QList<QColor> &ramp = _hoverRamps[static_cast<int>(component)][active ? 1 : 0];
+    if (ramp.isEmpty()) {
+        OverridableButtonColorState normalState;
+        OverridableButtonColorState hoverState;
+        switch (component) {
+        case ButtonComponent::Icon:
+        default:
+            normalState = OverridableButtonColorState::IconNormal;
+            hoverState = OverridableButtonColorState::IconHover;
+            break;
+        case ButtonComponent::Background:
+            normalState = OverridableButtonColorState::BackgroundNormal;
+            hoverState = OverridableButtonColorState::BackgroundHover;
+            break;
+        case ButtonComponent::Outline:
+            normalState = OverridableButtonColorState::OutlineNormal;
+            hoverState = OverridableButtonColorState::OutlineHover;
             break;
         }
+        const DecorationButtonPaletteGroup *group = active ? _active.get() : _inactive.get();
+        const QColor normalColor = groupColor(group, normalState);
+        const QColor hoverColor = groupColor(group, hoverState);
+        ramp.reserve(s_rampSteps + 1);
+        for (int step = 0; step <= s_rampSteps; step++) {
+            const qreal opacity = qreal(step) / s_rampSteps;
+            if (normalColor.isValid() && hoverColor.isValid()) {
+                ramp.append(KColorUtils::mix(normalColor, hoverColor, opacity));
+            } else if (hoverColor.isValid()) {
+                ramp.append(ColorTools::alphaMix(hoverColor, opacity));
+            } else {
+                ramp.append(QColor());
+            }
+        }
     }
-    if (!overrideButtonTypeValid) {
-        return;
+    return ramp.at(qBound(0, qRound(hoverOpacity * s_rampSteps), s_rampSteps));
+}
+
+QStringList ButtonOverrideColorTable::settingsStrings(const InternalSettings *decorationSettings)
+{
+    QStringList strings;
+    strings.reserve(s_buttonTypeCount * 2);
+    for (int i = 0; i < s_buttonTypeCount; i++) {
+        strings.append(decorationSettings->buttonOverrideColorsActive(i));
+    }
+    for (int i = 0; i < s_buttonTypeCount; i++) {
+        strings.append(decorationSettings->buttonOverrideColorsInactive(i));
     }
+    return strings;
+}
 
-    QByteArray overrideColorsSetting = active ? _decorationSettings->buttonOverrideColorsActive(static_cast<int>(_buttonType)).toUtf8()
-                                              : _decorationSettings->buttonOverrideColorsInactive(static_cast<int>(_buttonType)).toUtf8();
-    if (overrideColorsSetting.isEmpty()) {
-        return;
+std::shared_ptr<const ButtonOverrideColorTable> ButtonOverrideColorTable::forSettings(const InternalSettings *decorationSettings)
+{
+    // most recently used first; a process normally uses its default settings and at most a few exceptions. Compared by content as settings objects may be
+    // reloaded in place
+    static QList<std::shared_ptr<const ButtonOverrideColorTable>> s_tables;
+
+    const QStringList sources = settingsStrings(decorationSettings);
+    for (int i = 0; i < s_tables.count(); i++) {
+        if (s_tables.at(i)->m_sources == sources) {
+            if (i > 0) {
+                s_tables.move(i, 0);
+            }
+            return s_tables.first();
+        }
+    }
+
+    auto table = std::make_shared<ButtonOverrideColorTable>();
+    table->m_sources = sources;
+    for (int i = 0; i < s_buttonTypeCount; i++) {
+        table->m_rowSet[i][1] = compileRow(sources.at(i), table->m_rows[i][1]);
+        table->m_rowSet[i][0] = compileRow(sources.at(s_buttonTypeCount + i), table->m_rows[i][0]);
+    }
+
+    if (s_tables.count() >= 8) {
+        s_tables.removeLast();
+    }
+    s_tables.prepend(table);
+    return table;
+}
+
+const ButtonOverrideColorTable::Row *ButtonOverrideColorTable::row(DecorationButtonType buttonType, const bool active) const
+{
+    const int index = static_cast<int>(buttonType);
+    if (index < 0 || index >= s_buttonTypeCount || !m_rowSet[index][active ? 1 : 0]) {
+        return nullptr;
+    }
+    return &m_rows[index][active ? 1 : 0];
+}
+
+bool ButtonOverrideColorTable::compileRow(const QString &json, Row &row)
+{
+    if (json.isEmpty()) {
+        return false;
     }
 
-    QJsonDocument document = QJsonDocument::fromJson(overrideColorsSetting);
+    QJsonDocument document = QJsonDocument::fromJson(json.toUtf8());
 
     QJsonObject buttonStatesObject = document.object();
     bool overrideColorLoaded = false;
 
     for (auto i = buttonStatesObject.begin(); i < buttonStatesObject.end(); i++) {
+        const int overridableButtonColorStatesIndex = overridableButtonColorStatesJsonStrings.indexOf(i.key());
+        if (overridableButtonColorStatesIndex < 0)
+            continue;
+
         QJsonArray colorArray = i->toArray();
+        ButtonOverrideColor overrideColor;
         QColor color;
+        int colorItem;
         int colorOpacity;
-        int overridableButtonColorStatesIndex;
-        int overrideColorItemsIndex;
         switch (colorArray.count()) {
         case 0:
         default:
-            break;
+            continue;
         case 1:
-            overridableButtonColorStatesIndex = overridableButtonColorStatesJsonStrings.indexOf(i.key());
-            if (overridableButtonColorStatesIndex < 0)
-                break;
-
-            overrideColorItemsIndex = overrideColorItems.indexOf(colorArray[0].toString());
-            if (overrideColorItemsIndex == 0)
-                break;
-
-            color = overrideColorItemsIndexToColor(_decorationColorsActive, _decorationColorsInactive, overrideColorItemsIndex, active);
-            if (!color.isValid())
-                break;
-
-            buttonOverrideColors.insert(static_cast<OverridableButtonColorState>(overridableButtonColorStatesIndex), color);
-            overrideColorLoaded = true;
-            break;
         case 2:
-            overridableButtonColorStatesIndex = overridableButtonColorStatesJsonStrings.indexOf(i.key());
-            if (overridableButtonColorStatesIndex < 0)
-                break;
-
-            overrideColorItemsIndex = overrideColorItems.indexOf(colorArray[0].toString());
-            if (overrideColorItemsIndex == 0)
-                break;
-
-            color = overrideColorItemsIndexToColor(_decorationColorsActive, _decorationColorsInactive, overrideColorItemsIndex, active);
-            if (!color.isValid())
-                break;
-
-            colorOpacity = colorArray[1].toInt(-1);
-            if (colorOpacity >= 0 && colorOpacity <= 100) {
-                color.setAlphaF(colorOpacity / 100.0f);
-            } else {
-                break;
+            // a colour from the decoration colours, resolved when the palette is generated; "Custom" (0) and unknown items are ignored
+            colorItem = overrideColorItems.indexOf(colorArray[0].toString());
+            if (colorItem <= 0)
+                continue;
+            overrideColor.colorItem = static_cast<qint8>(colorItem);
+
+            if (colorArray.count() == 2) {
+                colorOpacity = colorArray[1].toInt(-1);
+                if (colorOpacity >= 0 && colorOpacity <= 100) {
+                    overrideColor.opacity = static_cast<qint8>(colorOpacity);
+                } else {
+                    continue;
+                }
             }
-
-            buttonOverrideColors.insert(static_cast<OverridableButtonColorState>(overridableButtonColorStatesIndex), color);
-            overrideColorLoaded = true;
             break;
         case 3:
-            overridableButtonColorStatesIndex = overridableButtonColorStatesJsonStrings.indexOf(i.key());
-            if (overridableButtonColorStatesIndex < 0)
-                break;
-
             color.setRed(colorArray[0].toInt());
             color.setGreen(colorArray[1].toInt());
             color.setBlue(colorArray[2].toInt());
             if (!color.isValid())
-                break;
+                continue;
 
-            buttonOverrideColors.insert(static_cast<OverridableButtonColorState>(overridableButtonColorStatesIndex), color);
-            overrideColorLoaded = true;
+            overrideColor.rgba = color.rgba64();
             break;
         case 4:
-            overridableButtonColorStatesIndex = overridableButtonColorStatesJsonStrings.indexOf(i.key());
-            if (overridableButtonColorStatesIndex < 0)
-                break;
-
             color.setRed(colorArray[1].toInt());
             color.setGreen(colorArray[2].toInt());
             color.setBlue(colorArray[3].toInt());
             if (!color.isValid())
-                break;
+                continue;
 
             colorOpacity = colorArray[0].toInt(-1);
             if (colorOpacity >= 0 && colorOpacity <= 100) {
                 color.setAlphaF(colorOpacity / 100.0f);
             } else {
-                break;
+                continue;
             }
 
-            buttonOverrideColors.insert(static_cast<OverridableButtonColorState>(overridableButtonColorStatesIndex), color);
-            overrideColorLoaded = true;
+            overrideColor.rgba = color.rgba64();
             break;
         }
+
+        overrideColor.set = true;
+        row[overridableButtonColorStatesIndex] = overrideColor;
+        overrideColorLoaded = true;
+    }
+
+    return overrideColorLoaded;
+}
+
+void DecorationButtonPalette::resolveButtonOverrideColors(const bool active)
+{
+    auto &buttonOverrideColors = active ? _buttonOverrideColorsActive : _buttonOverrideColorsInactive;
+    bool &buttonOverrideColorsPresent = active ? _buttonOverrideColorsPresentActive : _buttonOverrideColorsPresentInactive;
+
+    buttonOverrideColors.fill(QColor());
+    buttonOverrideColorsPresent = false;
+
+    const ButtonOverrideColorTable::Row *row = _buttonOverrideColorTable->row(_buttonType, active);
+    if (!row) {
+        return;
     }
 
-    buttonOverrideColorsPresent = overrideColorLoaded;
+    for (int i = 0; i < static_cast<int>(OverridableButtonColorState::COUNT); i++) {
+        const ButtonOverrideColor &overrideColor = (*row)[i];
+        if (!overrideColor.set) {
+            continue;
+        }
+
+        QColor color;
+        if (overrideColor.colorItem >= 0) {
+            color = overrideColorItemsIndexToColor(_decorationColorsActive, _decorationColorsInactive, overrideColor.colorItem, active);
+            if (!color.isValid())
+                continue;
+            if (overrideColor.opacity >= 0)
+                color.setAlphaF(overrideColor.opacity / 100.0f);
+        } else {
+            color = QColor::fromRgba64(overrideColor.rgba);
+        }
+
+        buttonOverrideColors[i] = color;
+        buttonOverrideColorsPresent = true;
+    }
 }
 
 QColor DecorationButtonPalette::overrideColorItemsIndexToColor(const DecorationPaletteGroup *decorationColorsActive,
@@ -570,14 +787,14 @@ void DecorationButtonPalette::generateButtonBackgroundPalette(const bool active)
     if (buttonOverrideColorsPresent) {
         auto &buttonOverrideColors = active ? _buttonOverrideColorsActive : _buttonOverrideColorsInactive;
 
-        if (buttonOverrideColors.value(OverridableButtonColorState::BackgroundNormal).isValid() && drawBackgroundNormally) {
-            backgroundNormal = buttonOverrideColors.value(OverridableButtonColorState::BackgroundNormal);
+        if (buttonOverrideColors[static_cast<int>(OverridableButtonColorState::BackgroundNormal)].isValid() && drawBackgroundNormally) {
+            backgroundNormal = buttonOverrideColors[static_cast<int>(OverridableButtonColorState::BackgroundNormal)];
         }
-        if (buttonOverrideColors.value(OverridableButtonColorState::BackgroundHover).isValid() && drawBackgroundOnHover) {
-            backgroundHover = buttonOverrideColors.value(OverridableButtonColorState::BackgroundHover);
+        if (buttonOverrideColors[static_cast<int>(OverridableButtonColorState::BackgroundHover)].isValid() && drawBackgroundOnHover) {
+            backgroundHover = buttonOverrideColors[static_cast<int>(OverridableButtonColorState::BackgroundHover)];
         }
-        if (buttonOverrideColors.value(OverridableButtonColorState::BackgroundPress).isValid() && drawBackgroundOnPress) {
-            backgroundPress = buttonOverrideColors.value(OverridableButtonColorState::BackgroundPress);
+        if (buttonOverrideColors[static_cast<int>(OverridableButtonColorState::BackgroundPress)].isValid() && drawBackgroundOnPress) {
+            backgroundPress = buttonOverrideColors[static_cast<int>(OverridableButtonColorState::BackgroundPress)];
         }
     }
 
@@ -797,14 +1014,14 @@ void DecorationButtonPalette::generateButtonForegroundPalette(const bool active)
     const bool buttonOverrideColorsPresent = active ? _buttonOverrideColorsPresentActive : _buttonOverrideColorsPresentInactive;
     if (buttonOverrideColorsPresent) {
         auto &buttonOverrideColors = active ? _buttonOverrideColorsActive : _buttonOverrideColorsInactive;
-        if (buttonOverrideColors.value(OverridableButtonColorState::IconNormal).isValid() && drawIconNormally) {
-            foregroundNormal = buttonOverrideColors.value(OverridableButtonColorState::IconNormal);
+        if (buttonOverrideColors[static_cast<int>(OverridableButtonColorState::IconNormal)].isValid() && drawIconNormally) {
+            foregroundNormal = buttonOverrideColors[static_cast<int>(OverridableButtonColorState::IconNormal)];
         }
-        if (buttonOverrideColors.value(OverridableButtonColorState::IconHover).isValid() && drawIconOnHover) {
-            foregroundHover = buttonOverrideColors.value(OverridableButtonColorState::IconHover);
+        if (buttonOverrideColors[static_cast<int>(OverridableButtonColorState::IconHover)].isValid() && drawIconOnHover) {
+            foregroundHover = buttonOverrideColors[static_cast<int>(OverridableButtonColorState::IconHover)];
         }
-        if (buttonOverrideColors.value(OverridableButtonColorState::IconPress).isValid() && drawIconOnPress) {
-            foregroundPress = buttonOverrideColors.value(OverridableButtonColorState::IconPress);
+        if (buttonOverrideColors[static_cast<int>(OverridableButtonColorState::IconPress)].isValid() && drawIconOnPress) {
+            foregroundPress = buttonOverrideColors[static_cast<int>(OverridableButtonColorState::IconPress)];
         }
     }
 
@@ -821,7 +1038,28 @@ void DecorationButtonPalette::adjustPoorForegroundContrast(QColor &baseForegroun
                                                            const bool active,
                                                            const DecorationPaletteGroup *decorationColorGroup)
 {
-    if (baseForegroundColor.isValid() && baseBackgroundColor.isValid() && baseForegroundColor.alpha() != 0) {
+    if (!baseForegroundColor.isValid() || baseForegroundColor.alpha() == 0) {
+        return;
+    }
+
+    // within generateAll(), other buttons often have the same colours, so reuse their corrections
+    const QRgba64 foreground = baseForegroundColor.rgba64();
+    const QRgba64 background = baseBackgroundColor.isValid() ? baseBackgroundColor.rgba64() : QRgba64::fromRgba64(0);
+    if (_foregroundContrastCache) {
+        for (const ForegroundContrastEntry &entry : std::as_const(*_foregroundContrastCache)) {
+            if (entry.foreground == foreground && entry.background == background && entry.backgroundValid == baseBackgroundColor.isValid()
+                && entry.active == active) {
+                baseForegroundColor = entry.result;
+                if (entry.cutOut) {
+                    cutOutParameter = true;
+                }
+                return;
+            }
+        }
+    }
+
+    bool cutOut = false;
+    if (baseBackgroundColor.isValid()) {
         if (_decorationSettings->onPoorIconContrast(active) == InternalSettings::EnumOnPoorIconContrast::TitleBarBackground) {
             QColor titleBarBase;
             titleBarBase = decorationColorGroup->titleBarBase;
@@ -832,7 +1070,7 @@ void DecorationButtonPalette::adjustPoorForegroundContrast(QColor &baseForegroun
                                                              _decorationSettings->poorIconContrastThreshold(active),
                                                              baseForegroundColor,
                                                              titleBarBase)) {
-                cutOutParameter = true;
+                cutOut = true;
             }
         } else if (_decorationSettings->onPoorIconContrast(active) == InternalSettings::EnumOnPoorIconContrast::BlackWhite) {
             ColorTools::getHigherContrastForegroundColor(baseForegroundColor,
@@ -840,13 +1078,20 @@ void DecorationButtonPalette::adjustPoorForegroundContrast(QColor &baseForegroun
                                                          _decorationSettings->poorIconContrastThreshold(active),
                                                          baseForegroundColor);
         }
-    } else if (baseForegroundColor.isValid() && baseForegroundColor.alpha() != 0) {
+    } else {
         // use BlackWhite mode even if TitleBarBackground selected as a poor contrast here will be with the titlebar
         ColorTools::getHigherContrastForegroundColor(baseForegroundColor,
                                                      decorationColorGroup->titleBarBase,
                                                      _decorationSettings->poorIconContrastThreshold(active),
                                                      baseForegroundColor);
     }
+
+    if (cutOut) {
+        cutOutParameter = true;
+    }
+    if (_foregroundContrastCache) {
+        _foregroundContrastCache->append({foreground, background, baseBackgroundColor.isValid(), active, baseForegroundColor, cutOut});
+    }
 }
 
 void DecorationButtonPalette::generateButtonOutlinePalette(const bool active)
@@ -985,14 +1230,14 @@ void DecorationButtonPalette::generateButtonOutlinePalette(const bool active)
     const bool buttonOverrideColorsPresent = active ? _buttonOverrideColorsPresentActive : _buttonOverrideColorsPresentInactive;
     if (buttonOverrideColorsPresent) {
         auto &buttonOverrideColors = active ? _buttonOverrideColorsActive : _buttonOverrideColorsInactive;
-        if (buttonOverrideColors.value(OverridableButtonColorState::OutlineNormal).isValid() && drawOutlineNormally) {
-            outlineNormal = buttonOverrideColors.value(OverridableButtonColorState::OutlineNormal);
+        if (buttonOverrideColors[static_cast<int>(OverridableButtonColorState::OutlineNormal)].isValid() && drawOutlineNormally) {
+            outlineNormal = buttonOverrideColors[static_cast<int>(OverridableButtonColorState::OutlineNormal)];
         }
-        if (buttonOverrideColors.value(OverridableButtonColorState::OutlineHover).isValid() && drawOutlineOnHover) {
-            outlineHover = buttonOverrideColors.value(OverridableButtonColorState::OutlineHover);
+        if (buttonOverrideColors[static_cast<int>(OverridableButtonColorState::OutlineHover)].isValid() && drawOutlineOnHover) {
+            outlineHover = buttonOverrideColors[static_cast<int>(OverridableButtonColorState::OutlineHover)];
         }
-        if (buttonOverrideColors.value(OverridableButtonColorState::OutlinePress).isValid() && drawOutlineOnPress) {
-            outlinePress = buttonOverrideColors.value(OverridableButtonColorState::OutlinePress);
+        if (buttonOverrideColors[static_cast<int>(OverridableButtonColorState::OutlinePress)].isValid() && drawOutlineOnPress) {
+            outlinePress = buttonOverrideColors[static_cast<int>(OverridableButtonColorState::OutlinePress)];
         }
     }
 
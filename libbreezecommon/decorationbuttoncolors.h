@@ -8,16 +8,22 @@
 
 #include "breeze.h"
 #include "breezecommon_export.h"
-#include "decorationcolors.h"
 #include <KColorScheme>
 #include <QColor>
+#include <QVarLengthArray>
+#include <array>
 #include <memory>
+#include <optional>
 
 namespace Breeze
 {
 
 struct DecorationPaletteGroup;
 class DecorationColors;
+class DecorationButtonPalette;
+
+//* button palettes indexed by DecorationButtonType
+using DecorationButtonPaletteTable = std::array<std::optional<DecorationButtonPalette>, static_cast<int>(DecorationButtonType::COUNT)>;
 
 const QList<DecorationButtonType> coloredWindowDecorationButtonTypes{
     DecorationButtonType::Menu,
@@ -97,6 +103,47 @@ const QStringList overrideColorItems{
     QStringLiteral("WindowShadowInactive"),
 };
 
+//* one button state's override colour, compiled from the ButtonOverrideColors JSON settings
+struct BREEZECOMMON_EXPORT ButtonOverrideColor {
+    //* whether an override colour is set for the state
+    bool set = false;
+    //* index into overrideColorItems of a colour taken from the decoration colours, or -1 if rgba holds a fixed colour
+    qint8 colorItem = -1;
+    //* opacity percentage to apply to a colorItem colour, or -1 to use the colour's own opacity
+    qint8 opacity = -1;
+    QRgba64 rgba = QRgba64::fromRgba64(0);
+};
+
+/**
+ *  @brief Override colours of all button types, compiled from their ButtonOverrideColors JSON settings so that generating palettes needs no parsing.
+ *         Tables are shared between palettes and only recompiled when the settings strings change
+ */
+class BREEZECOMMON_EXPORT ButtonOverrideColorTable
+{
+public:
+    using Row = std::array<ButtonOverrideColor, static_cast<int>(OverridableButtonColorState::COUNT)>;
+
+    //* the compiled table for the override colour settings in decorationSettings
+    static std::shared_ptr<const ButtonOverrideColorTable> forSettings(const InternalSettings *decorationSettings);
+
+    //* override colours of the given button type and group, indexed by OverridableButtonColorState, or nullptr if none are set
+    const Row *row(DecorationButtonType buttonType, const bool active) const;
+
+private:
+    static constexpr int s_buttonTypeCount = InternalSettings::EnumButtonOverrideColorsActiveButtonType::COUNT;
+
+    //* the setting strings, active then inactive
+    static QStringList settingsStrings(const InternalSettings *decorationSettings);
+    static bool compileRow(const QString &json, Row &row);
+
+    //* the strings compiled, from settingsStrings()
+    QStringList m_sources;
+
+    //* indexed by button type, then inactive/active
+    std::array<std::array<Row, 2>, s_buttonTypeCount> m_rows;
+    std::array<std::array<bool, 2>, s_buttonTypeCount> m_rowSet{};
+};
+
 struct BREEZECOMMON_EXPORT DecorationButtonPaletteGroup {
     QColor foregroundPress;
     QColor foregroundHover;
@@ -130,6 +177,19 @@ public:
                   const DecorationPaletteGroup *decorationColorsInactive,
                   const bool generateOneGroupOnly = false,
                   const bool oneGroupActiveState = true);
+
+    /**
+     * @brief Generates the palettes of all the given button types in one pass, equivalent to calling generate() on each.
+     *        Button types without type-specific colours or override colours all have the same palette, so it is generated once and copied,
+     *        and icon contrast corrections are shared between buttons
+     * @param palettes table of palettes indexed by DecorationButtonType; unset entries are skipped
+     */
+    static void generateAll(DecorationButtonPaletteTable &palettes,
+                            InternalSettingsPtr decorationSettings,
+                            const DecorationPaletteGroup *decorationColorsActive,
+                            const DecorationPaletteGroup *decorationColorsInactive,
+                            const bool generateOneGroupOnly = false,
+                            const bool oneGroupActiveState = true);
     const DecorationButtonPaletteGroup *active() const
     {
         return _active.get();
@@ -149,8 +209,45 @@ public:
                                                  const int overrideColorItemsIndex,
                                                  const bool active);
 
+    //* the colour of the given state part-way through an inactive (0) to active (1) state change animation, looked up from a precomputed ramp
+    QColor activeStateRampColor(OverridableButtonColorState state, qreal activeOpacity) const;
+
+    //* the colour of the given component part-way through a normal (0) to hover (1) animation, looked up from a precomputed ramp
+    QColor hoverRampColor(ButtonComponent component, const bool active, qreal hoverOpacity) const;
+
+    //* number of steps in each colour ramp
+    static constexpr int s_rampSteps = 64;
+
 private:
-    void decodeButtonOverrideColors(const bool active);
+    //* a poor icon contrast correction, shared by the buttons of one generateAll() pass
+    struct ForegroundContrastEntry {
+        QRgba64 foreground;
+        QRgba64 background;
+        bool backgroundValid;
+        bool active;
+        QColor result;
+        bool cutOut;
+    };
+    using ForegroundContrastCache = QVarLengthArray<ForegroundContrastEntry, 32>;
+
+    //* whether the button type's colours can differ from other button types' regardless of override colours
+    static bool hasTypeSpecificColors(DecorationButtonType buttonType);
+
+    //* buttonOverrideColorTable must be the table for decorationSettings, resolved once by the caller for all the palettes it generates
+    void setDecorationColors(InternalSettingsPtr decorationSettings,
+                             const DecorationPaletteGroup *decorationColorsActive,
+                             const DecorationPaletteGroup *decorationColorsInactive,
+                             const std::shared_ptr<const ButtonOverrideColorTable> &buttonOverrideColorTable);
+    void generateGroup(const bool active);
+    //* copy the given group's colours from another palette of the same settings, which must have no override colours for the group
+    void copyGroup(const DecorationButtonPalette &other, const bool active);
+
+    static QColor groupColor(const DecorationButtonPaletteGroup *group, OverridableButtonColorState state);
+    //* discard the colour ramps, to be rebuilt from the current palette on next use
+    void clearRamps();
+
+    //* resolve the compiled override colours of this button against the current decoration colours
+    void resolveButtonOverrideColors(const bool active);
     void generateBistateColors(ButtonComponent component,
                                const bool active,
                                QColor baseColor,
@@ -181,11 +278,22 @@ private:
     bool _buttonOverrideColorsPresentActive{false};
     bool _buttonOverrideColorsPresentInactive{false};
 
-    QMap<OverridableButtonColorState, QColor> _buttonOverrideColorsActive;
-    QMap<OverridableButtonColorState, QColor> _buttonOverrideColorsInactive;
+    std::shared_ptr<const ButtonOverrideColorTable> _buttonOverrideColorTable;
+
+    //* indexed by OverridableButtonColorState
+    std::array<QColor, static_cast<int>(OverridableButtonColorState::COUNT)> _buttonOverrideColorsActive;
+    std::array<QColor, static_cast<int>(OverridableButtonColorState::COUNT)> _buttonOverrideColorsInactive;
 
     std::shared_ptr<DecorationButtonPaletteGroup> _active;
     std::shared_ptr<DecorationButtonPaletteGroup> _inactive;
+
+    //* set only during generateAll()
+    ForegroundContrastCache *_foregroundContrastCache = nullptr;
+
+    //* colour ramps, of s_rampSteps + 1 colours each, built on first use after each generate()
+    mutable std::array<QList<QColor>, static_cast<int>(OverridableButtonColorState::COUNT)> _activeStateRamps;
+    //* indexed by component, then inactive/active
+    mutable std::array<std::array<QList<QColor>, 2>, static_cast<int>(ButtonComponent::COUNT)> _hoverRamps;
 };
 
 }
@@ -14,7 +14,7 @@ namespace Breeze
 QPalette DecorationColors::s_cachedKdeGlobalPalette;
 std::unique_ptr<DecorationPaletteGroup> DecorationColors::s_cachedDecorationPaletteGroupActive;
 std::unique_ptr<DecorationPaletteGroup> DecorationColors::s_cachedDecorationPaletteGroupInactive;
-std::map<DecorationButtonType, DecorationButtonPalette> DecorationColors::s_cachedButtonPalettes;
+DecorationButtonPaletteTable DecorationColors::s_cachedButtonPalettes;
 QByteArray DecorationColors::s_settingsUpdateUuid = "";
 bool DecorationColors::s_cachedColorsGenerated = false;
 
@@ -22,7 +22,7 @@ DecorationColors::DecorationColors(const bool useCachedPalette, const bool forAp
     : m_forAppStyle(forAppStyle)
 {
     if (m_forAppStyle) {
-        m_useCachedPalette = false; // different apps can't access the same memory TODO:implement an appStyle cache using shared memory
+        m_useCachedPalette = false; // different apps can't access the same memory; the app style shares colours between processes with SharedDecorationColors instead
     } else {
         m_useCachedPalette = useCachedPalette;
     }
@@ -41,22 +41,24 @@ DecorationColors::DecorationColors(const bool useCachedPalette, const bool forAp
         *m_decorationPaletteGroupInactive = std::make_unique<DecorationPaletteGroup>();
     }
 
-    if (!m_buttonPalettes->size() && !m_forAppStyle) { // appStyle should generate buttons separately
+    if (!m_forAppStyle) { // appStyle should generate buttons separately
         const QList<DecorationButtonType> &coloredButtonTypes = m_forAppStyle ? coloredAppStyleDecorationButtonTypes : coloredWindowDecorationButtonTypes;
 
-        // initialise m_buttonPalettes map so that only generate() needs called later -- ensures the values in the map are at the same memory location
+        // initialise m_buttonPalettes table so that only generate() needs called later -- ensures the values in the table are at the same memory location
         for (int i = 0; i < coloredButtonTypes.count(); i++) {
-            DecorationButtonPalette buttonPalette(coloredButtonTypes[i]);
-            m_buttonPalettes->insert({coloredButtonTypes[i], buttonPalette});
+            std::optional<DecorationButtonPalette> &buttonPalette = (*m_buttonPalettes)[static_cast<int>(coloredButtonTypes[i])];
+            if (!buttonPalette) {
+                buttonPalette.emplace(coloredButtonTypes[i]);
+            }
         }
     }
 }
 
 DecorationButtonPalette *DecorationColors::buttonPalette(DecorationButtonType type) const
 {
-    auto it = m_buttonPalettes->find(type);
-    if (it != m_buttonPalettes->end()) {
-        return &(it->second);
+    const int index = static_cast<int>(type);
+    if (index >= 0 && index < static_cast<int>(DecorationButtonType::COUNT) && (*m_buttonPalettes)[index]) {
+        return &*(*m_buttonPalettes)[index];
     } else {
         return nullptr;
     }
@@ -88,6 +90,14 @@ void DecorationColors::generateDecorationColors(const QPalette &palette,
     *m_colorsGenerated = true;
 }
 
+void DecorationColors::setDecorationColors(const QPalette &palette, const DecorationPaletteGroup &active, const DecorationPaletteGroup &inactive)
+{
+    *m_basePalette = palette;
+    **m_decorationPaletteGroupActive = active;
+    **m_decorationPaletteGroupInactive = inactive;
+    *m_colorsGenerated = true;
+}
+
 void DecorationColors::generateDecorationAndButtonColors(const QPalette &palette,
                                                          const QSharedPointer<InternalSettings> decorationSettings,
                                                          QColor titleBarTextActive,
@@ -106,9 +116,7 @@ void DecorationColors::generateDecorationAndButtonColors(const QPalette &palette
                              titleBarBaseInactive,
                              settingsUpdateUuid);
 
-    for (auto i = m_buttonPalettes->begin(); i != m_buttonPalettes->end(); i++) {
-        i->second.generate(decorationSettings, this->active(), this->inactive(), generateOneGroupOnly, oneGroupActiveState);
-    }
+    DecorationButtonPalette::generateAll(*m_buttonPalettes, decorationSettings, this->active(), this->inactive(), generateOneGroupOnly, oneGroupActiveState);
 }
 
 void DecorationColors::generateDecorationPaletteGroup(const QPalette &palette,
@@ -13,7 +13,6 @@
 #include <QColor>
 #include <QObject>
 #include <QPalette>
-#include <map>
 #include <memory>
 
 namespace Breeze
@@ -146,6 +145,14 @@ public:
                                   const bool generateOneGroupOnly = false,
                                   const bool oneGroupActiveState = false);
 
+    /**
+     * @brief Sets the decorationColors to colours generated previously, e.g. by another process, excluding button colours
+     * @param palette The palette the colours were generated from
+     * @param active Active colours
+     * @param inactive Inactive colours
+     */
+    void setDecorationColors(const QPalette &palette, const DecorationPaletteGroup &active, const DecorationPaletteGroup &inactive);
+
     static void readSystemTitleBarColors(KSharedConfig::Ptr kdeGlobalConfig,
                                          QColor &systemBaseActive,
                                          QColor &systemBaseInactive,
@@ -177,7 +184,7 @@ private:
     QPalette *m_basePalette;
     std::unique_ptr<DecorationPaletteGroup> *m_decorationPaletteGroupActive;
     std::unique_ptr<DecorationPaletteGroup> *m_decorationPaletteGroupInactive;
-    std::map<DecorationButtonType, DecorationButtonPalette> *m_buttonPalettes;
+    DecorationButtonPaletteTable *m_buttonPalettes;
     bool *m_colorsGenerated;
     void *m_settingsUpdateUuid;
 
@@ -185,14 +192,14 @@ private:
     QPalette m_nonCachedClientPalette;
     std::unique_ptr<DecorationPaletteGroup> m_nonCachedDecorationPaletteGroupActive;
     std::unique_ptr<DecorationPaletteGroup> m_nonCachedDecorationPaletteGroupInactive;
-    std::map<DecorationButtonType, DecorationButtonPalette> m_nonCachedButtonPalettes;
+    DecorationButtonPaletteTable m_nonCachedButtonPalettes;
     bool m_nonCachedColorsGenerated = false;
 
     //* cached data used for window decorations
     static QPalette s_cachedKdeGlobalPalette;
     static std::unique_ptr<DecorationPaletteGroup> s_cachedDecorationPaletteGroupActive;
     static std::unique_ptr<DecorationPaletteGroup> s_cachedDecorationPaletteGroupInactive;
-    static std::map<DecorationButtonType, DecorationButtonPalette> s_cachedButtonPalettes;
+    static DecorationButtonPaletteTable s_cachedButtonPalettes;
     static QByteArray s_settingsUpdateUuid;
     static bool s_cachedColorsGenerated;
 };
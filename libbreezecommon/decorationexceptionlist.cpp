@@ -39,37 +39,37 @@ void DecorationExceptionList::readConfig(KSharedConfig::Ptr config, const bool r
     }
 
     // load user-set exceptions from the config file
+    // the base settings are loaded once, and each exception is an in-memory copy of them overlaid with the few keys an exception can set
+    if (!config->hasGroup(exceptionGroupName(0))) {
+        return;
+    }
+
+    InternalSettings base;
+    base.load();
+
     for (int index = 0; config->hasGroup(groupName = exceptionGroupName(index)); ++index) {
-        readIndividualExceptionFromConfig(config, groupName, _exceptions);
+        readIndividualExceptionFromConfig(config, base, groupName, _exceptions);
     }
 }
 
-void DecorationExceptionList::readIndividualExceptionFromConfig(KSharedConfig::Ptr config, QString &groupName, InternalSettingsList &appendTo)
+void DecorationExceptionList::readIndividualExceptionFromConfig(KSharedConfig::Ptr config,
+                                                                const InternalSettings &base,
+                                                                QString &groupName,
+                                                                InternalSettingsList &appendTo)
 {
-    // create exception
-    InternalSettings exception;
-
-    // reset group
-    readConfig(&exception, config.data(), groupName);
-
-    // create new configuration
+    // create new configuration as a copy of the base settings, avoiding a full load() from the config file
     InternalSettingsPtr configuration(new InternalSettings());
-    configuration.data()->load();
-
-    // apply changes from exception
-    configuration->setEnabled(exception.enabled());
-    configuration->setExceptionWindowPropertyType(exception.exceptionWindowPropertyType());
-    configuration->setExceptionProgramNamePattern(exception.exceptionProgramNamePattern());
-    configuration->setExceptionWindowPropertyPattern(exception.exceptionWindowPropertyPattern());
+    copyConfig(&base, configuration.data());
 
-    configuration->setExceptionPreset(exception.exceptionPreset());
-    configuration->setExceptionBorder(exception.exceptionBorder());
+    // overlay the exception keys from the exception group
+    // BorderSize is only overridden when the exception sets ExceptionBorder
+    QStringList keys = windecoExceptionKeys;
+    keys.removeOne(QStringLiteral("BorderSize"));
+    readConfig(configuration.data(), config.data(), groupName, keys);
 
-    if (exception.exceptionBorder())
-        configuration->setBorderSize(exception.borderSize());
-    configuration->setHideTitleBar(exception.hideTitleBar());
-    configuration->setOpaqueTitleBar(exception.opaqueTitleBar());
-    configuration->setPreventApplyOpacityToHeader(exception.preventApplyOpacityToHeader());
+    if (configuration->exceptionBorder()) {
+        readConfig(configuration.data(), config.data(), groupName, {QStringLiteral("BorderSize")});
+    }
 
     // append to exceptions
     appendTo.append(configuration);
@@ -80,8 +80,8 @@ void DecorationExceptionList::readExceptionEnabledFromConfig(KSharedConfig::Ptr
     // create exception
     InternalSettings exception;
 
-    // reset group
-    readConfig(&exception, config.data(), groupName);
+    // read only the enabled flag from the group
+    readConfig(&exception, config.data(), groupName, {QStringLiteral("Enabled")});
 
     // append to exceptions
     settingsList[index]->setEnabled(exception.enabled());
@@ -168,6 +168,33 @@ void DecorationExceptionList::writeDefaultsConfig(KCoreConfigSkeleton *skeleton,
     }
 }
 
+//______________________________________________________________
+void DecorationExceptionList::readConfig(KCoreConfigSkeleton *skeleton, KConfig *config, const QString &groupName, const QStringList &keys)
+{
+    for (const QString &key : keys) {
+        KConfigSkeletonItem *item(skeleton->findItem(key));
+        if (!item)
+            continue;
+
+        // read from the exception group, then restore the item's own group so that the skeleton still saves to where it loaded from
+        const QString originalGroup = item->group();
+        item->setGroup(groupName);
+        item->readConfig(config);
+        item->setGroup(originalGroup);
+    }
+}
+
+//______________________________________________________________
+void DecorationExceptionList::copyConfig(const KCoreConfigSkeleton *source, KCoreConfigSkeleton *destination)
+{
+    // both skeletons are of the same generated class, so their items are in the same order
+    const auto sourceItems = source->items();
+    const auto destinationItems = destination->items();
+    for (int i = 0; i < sourceItems.size() && i < destinationItems.size(); ++i) {
+        destinationItems[i]->setProperty(sourceItems[i]->property());
+    }
+}
+
 //______________________________________________________________
 void DecorationExceptionList::readConfig(KCoreConfigSkeleton *skeleton, KConfig *config, const QString &groupName)
 {
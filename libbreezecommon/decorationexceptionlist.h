@@ -64,6 +64,12 @@ protected:
     //! read configuration
     static void readConfig(KCoreConfigSkeleton *, KConfig *, const QString &);
 
+    //! read configuration for the given keys only
+    static void readConfig(KCoreConfigSkeleton *, KConfig *, const QString &, const QStringList &keys);
+
+    //! copy all item values from one skeleton to another of the same class, without reading the config file
+    static void copyConfig(const KCoreConfigSkeleton *source, KCoreConfigSkeleton *destination);
+
     //! write configuration
     static void writeConfig(KCoreConfigSkeleton *, KConfig *, const QString &);
 
@@ -71,7 +77,7 @@ protected:
     void writeDefaultsConfig(KCoreConfigSkeleton *skeleton, KConfig *config, const QString &groupName);
 
 private:
-    void readIndividualExceptionFromConfig(KSharedConfig::Ptr config, QString &groupName, InternalSettingsList &appendTo);
+    void readIndividualExceptionFromConfig(KSharedConfig::Ptr config, const InternalSettings &base, QString &groupName, InternalSettingsList &appendTo);
     void readExceptionEnabledFromConfig(KSharedConfig::Ptr config, QString groupName, InternalSettingsList &settingsList, int index);
 
     //! exceptions
@@ -0,0 +1,119 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Paul A McAuley <kde@paulmcauley.com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "exceptionmatcher.h"
+
+#include <limits>
+
+namespace Breeze
+{
+
+//__________________________________________________________________
+void ExceptionMatcher::compile(const InternalSettingsList &exceptions)
+{
+    m_classPatterns.clear();
+    m_titlePatterns.clear();
+    m_programNamePatterns.clear();
+    m_classMemo.clear();
+    m_titleMemo.clear();
+    m_programNameMemo.clear();
+
+    auto compilePattern = [](const QString &pattern, int index, QVector<CompiledPattern> &appendTo) {
+        QRegularExpression regularExpression(pattern);
+        if (!regularExpression.isValid()) {
+            return;
+        }
+        regularExpression.optimize();
+        appendTo.append({index, std::move(regularExpression)});
+    };
+
+    for (int i = 0; i < exceptions.size(); ++i) {
+        const auto &internalSettings = exceptions.at(i);
+
+        // discard disabled exceptions
+        if (!internalSettings->enabled()) {
+            continue;
+        }
+
+        // discard exceptions with empty exception patterns
+        if (!internalSettings->exceptionWindowPropertyPattern().isEmpty()) {
+            switch (internalSettings->exceptionWindowPropertyType()) {
+            case InternalSettings::EnumExceptionWindowPropertyType::ExceptionWindowTitle:
+                compilePattern(internalSettings->exceptionWindowPropertyPattern(), i, m_titlePatterns);
+                break;
+
+            default:
+            case InternalSettings::EnumExceptionWindowPropertyType::ExceptionWindowClassName:
+                compilePattern(internalSettings->exceptionWindowPropertyPattern(), i, m_classPatterns);
+                break;
+            }
+        }
+
+        if (!internalSettings->exceptionProgramNamePattern().isEmpty()) {
+            compilePattern(internalSettings->exceptionProgramNamePattern(), i, m_programNamePatterns);
+        }
+    }
+}
+
+//__________________________________________________________________
+int ExceptionMatcher::firstMatch(const QVector<CompiledPattern> &patterns, const QString &value, int limit)
+{
+    for (const CompiledPattern &pattern : patterns) {
+        if (pattern.index >= limit) {
+            break;
+        }
+        if (pattern.regularExpression.match(value).hasMatch()) {
+            return pattern.index;
+        }
+    }
+    return -1;
+}
+
+//__________________________________________________________________
+int ExceptionMatcher::memoisedMatch(QHash<QString, int> &memo, const QVector<CompiledPattern> &patterns, const QString &value, int limit)
+{
+    // the memo stores the unlimited result; a result at or beyond the limit is equivalent to no match
+    auto it = memo.constFind(value);
+    int index;
+    if (it != memo.constEnd()) {
+        index = it.value();
+    } else {
+        index = firstMatch(patterns, value, std::numeric_limits<int>::max());
+        if (memo.size() >= s_maxMemoEntries) {
+            memo.clear();
+        }
+        memo.insert(value, index);
+    }
+    return index < limit ? index : -1;
+}
+
+//__________________________________________________________________
+int ExceptionMatcher::matchWindow(const QString &windowClass, const QString &caption)
+{
+    int index = m_classPatterns.isEmpty() ? -1 : memoisedMatch(m_classMemo, m_classPatterns, windowClass, std::numeric_limits<int>::max());
+
+    // exceptions are applied in list order, so only a title exception earlier in the list than the class match can take precedence
+    if (!m_titlePatterns.isEmpty() && index != 0) {
+        const int limit = index < 0 ? std::numeric_limits<int>::max() : index;
+        const int titleIndex = memoisedMatch(m_titleMemo, m_titlePatterns, caption, limit);
+        if (titleIndex >= 0) {
+            index = titleIndex;
+        }
+    }
+
+    return index;
+}
+
+//__________________________________________________________________
+int ExceptionMatcher::matchProgramName(const QString &programName)
+{
+    if (m_programNamePatterns.isEmpty()) {
+        return -1;
+    }
+    return memoisedMatch(m_programNameMemo, m_programNamePatterns, programName, std::numeric_limits<int>::max());
+}
+
+}
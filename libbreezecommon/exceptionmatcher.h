@@ -0,0 +1,68 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Paul A McAuley <kde@paulmcauley.com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#pragma once
+
+#include "breeze.h"
+#include "breezecommon_export.h"
+
+#include <QHash>
+#include <QRegularExpression>
+#include <QString>
+#include <QVector>
+
+namespace Breeze
+{
+
+/**
+ * @brief Matches windows and programs against an exception list, with patterns compiled (and JIT-optimised) once per list.
+ *        Window class and window title patterns are kept in separate groups and their results memoised separately,
+ *        so a caption change only re-runs the title patterns which precede the window's first class match.
+ */
+class BREEZECOMMON_EXPORT ExceptionMatcher
+{
+public:
+    //* compile the patterns of the enabled exceptions; previous patterns and memoised results are discarded
+    void compile(const InternalSettingsList &exceptions);
+
+    //* index in the exception list of the first exception matching the window, or -1 if none match
+    int matchWindow(const QString &windowClass, const QString &caption);
+
+    //* index in the exception list of the first exception matching the program name, or -1 if none match
+    int matchProgramName(const QString &programName);
+
+    //* whether any enabled exception matches on window title, i.e. whether a caption change can change the matched exception
+    bool hasTitlePatterns() const
+    {
+        return !m_titlePatterns.isEmpty();
+    }
+
+private:
+    struct CompiledPattern {
+        int index;
+        QRegularExpression regularExpression;
+    };
+
+    //* index of the first pattern in the (index-ordered) group matching value, only considering patterns with index < limit. Returns -1 if no match
+    static int firstMatch(const QVector<CompiledPattern> &patterns, const QString &value, int limit);
+
+    //* look up a memoised result, or match and memoise
+    static int memoisedMatch(QHash<QString, int> &memo, const QVector<CompiledPattern> &patterns, const QString &value, int limit);
+
+    QVector<CompiledPattern> m_classPatterns;
+    QVector<CompiledPattern> m_titlePatterns;
+    QVector<CompiledPattern> m_programNamePatterns;
+
+    //* memoised results, keyed by window class, caption and program name respectively; valid until the next compile()
+    QHash<QString, int> m_classMemo;
+    QHash<QString, int> m_titleMemo;
+    QHash<QString, int> m_programNameMemo;
+
+    //* bound on each memo, as captions in particular can change constantly
+    static constexpr int s_maxMemoEntries = 256;
+};
+
+}
@@ -5,6 +5,9 @@
  */
 #include "geometrytools.h"
 
+#include <QHash>
+#include <QtMath>
+
 namespace Breeze
 {
 
@@ -67,4 +70,82 @@ QPainterPath GeometryTools::roundedPath(const QRectF &rect, Corners corners, qre
     return path;
 }
 
+//________________________________________________________________
+const QVector<int> &GeometryTools::cornerInsets(qreal radius)
+{
+    // per-thread so that no locking is needed; there are only ever a handful of radii in use
+    thread_local QHash<qreal, QVector<int>> s_insets;
+
+    auto it = s_insets.find(radius);
+    if (it == s_insets.end()) {
+        QVector<int> insets;
+        const int rows = qCeil(radius);
+        insets.reserve(rows);
+        for (int row = 0; row < rows; ++row) {
+            // sample the arc at the centre of the pixel row
+            const qreal dy = radius - (row + 0.5);
+            insets.append(qRound(radius - qSqrt(qMax(qreal(0), radius * radius - dy * dy))));
+        }
+        if (s_insets.size() >= 32) {
+            s_insets.clear();
+        }
+        it = s_insets.insert(radius, insets);
+    }
+    return *it;
+}
+
+//________________________________________________________________
+QRegion GeometryTools::roundedRegion(const QRect &rect, Corners corners, qreal radius)
+{
+    if (!rect.isValid()) {
+        return QRegion();
+    }
+
+    radius = qMin(radius, qreal(qMin(rect.width(), rect.height())) / 2);
+    if (corners == 0 || radius <= 0) {
+        return QRegion(rect);
+    }
+
+    const QVector<int> &insets = cornerInsets(radius);
+    const int cornerRows = insets.size();
+
+    // one band per run of rows with the same insets; QRegion::setRects() takes bands sorted top to bottom
+    QVector<QRect> rects;
+    rects.reserve(2 * cornerRows + 1);
+    auto appendRow = [&rects, &rect](int y, int insetLeft, int insetRight) {
+        if (!rects.isEmpty()) {
+            QRect &last = rects.last();
+            if (last.bottom() == y - 1 && last.left() == rect.left() + insetLeft && last.right() == rect.right() - insetRight) {
+                last.setBottom(y);
+                return;
+            }
+        }
+        rects.append(QRect(QPoint(rect.left() + insetLeft, y), QPoint(rect.right() - insetRight, y)));
+    };
+
+    const bool topRounded = corners & CornersTop;
+    const bool bottomRounded = corners & CornersBottom;
+    const int topRows = topRounded ? qMin(cornerRows, rect.height()) : 0;
+    // with an odd height the clamped radius has a shared half row, which must only be emitted once
+    const int bottomRows = bottomRounded ? qMin(cornerRows, rect.height() - topRows) : 0;
+
+    for (int row = 0; row < topRows; ++row) {
+        appendRow(rect.top() + row, (corners & CornerTopLeft) ? insets[row] : 0, (corners & CornerTopRight) ? insets[row] : 0);
+    }
+
+    // straight sides
+    const int middleHeight = rect.height() - topRows - bottomRows;
+    if (middleHeight > 0) {
+        rects.append(QRect(rect.left(), rect.top() + topRows, rect.width(), middleHeight));
+    }
+
+    for (int row = bottomRows - 1; row >= 0; --row) {
+        appendRow(rect.bottom() - row, (corners & CornerBottomLeft) ? insets[row] : 0, (corners & CornerBottomRight) ? insets[row] : 0);
+    }
+
+    QRegion region;
+    region.setRects(rects.constData(), rects.size());
+    return region;
+}
+
 }
@@ -10,6 +10,8 @@
 #include "breezecommon_export.h"
 
 #include <QPainterPath>
+#include <QRegion>
+#include <QVector>
 
 namespace Breeze
 {
@@ -22,6 +24,16 @@ class BREEZECOMMON_EXPORT GeometryTools
 {
 public:
     static QPainterPath roundedPath(const QRectF &rect, Corners corners, qreal radius);
+
+    /**
+     * @brief Returns the region covered by a rounded rectangle, built directly as one rectangle per distinct row of a corner plus one for the straight
+     *        sides, rather than by rasterising a QPainterPath polygon. The corner insets are calculated once per radius and reused for any size of rect.
+     */
+    static QRegion roundedRegion(const QRect &rect, Corners corners, qreal radius);
+
+private:
+    //* horizontal inset of each pixel row of a corner of the given radius, starting at the outermost row
+    static const QVector<int> &cornerInsets(qreal radius);
 };
 
 }
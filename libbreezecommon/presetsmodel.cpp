@@ -6,12 +6,69 @@
 
 #include "presetsmodel.h"
 #include <KConfigGroup>
+#include <QDateTime>
 #include <QDir>
+#include <QFileInfo>
 #include <QRegularExpression>
+#include <QStandardPaths>
 
 namespace Breeze
 {
 
+namespace
+{
+//* decoded values of a preset, keyed by skeleton item key
+using PresetValues = QHash<QString, QVariant>;
+
+//* presets already decoded from a presets config file, valid while the file's modification time and size are unchanged
+struct PresetCache {
+    QString filePath;
+    QDateTime lastModified;
+    qint64 size = -1;
+    QHash<QString, PresetValues> presets;
+};
+
+PresetCache &presetCache()
+{
+    static PresetCache cache;
+    return cache;
+}
+
+QString configFilePath(const KConfig *config)
+{
+    const QString name = config->name();
+    if (QDir::isAbsolutePath(name)) {
+        return name;
+    }
+    return QStandardPaths::writableLocation(config->locationType()) + QLatin1Char('/') + name;
+}
+
+//* the preset cache for the presets config, emptied first if it was filled from a different or since-modified file
+PresetCache &validPresetCache(const KConfig *presetsConfig)
+{
+    PresetCache &cache = presetCache();
+
+    const QString filePath = configFilePath(presetsConfig);
+    const QFileInfo fileInfo(filePath);
+    const QDateTime lastModified = fileInfo.lastModified();
+    const qint64 size = fileInfo.exists() ? fileInfo.size() : -1;
+
+    if (filePath != cache.filePath || lastModified != cache.lastModified || size != cache.size) {
+        cache.presets.clear();
+        cache.filePath = filePath;
+        cache.lastModified = lastModified;
+        cache.size = size;
+    }
+    return cache;
+}
+
+//* used when a preset is modified in memory, before it is synced to the file
+void invalidatePresetCache()
+{
+    presetCache().presets.clear();
+}
+}
+
 QString PresetsModel::presetGroupName(const QString str)
 {
     return QString("Windeco Preset %1").arg(str);
@@ -21,6 +78,7 @@ QString PresetsModel::presetGroupName(const QString str)
 void PresetsModel::writePreset(KCoreConfigSkeleton *skeleton, KConfig *presetsConfig, const QString &presetName)
 {
     QString groupName = presetGroupName(presetName);
+    invalidatePresetCache();
 
     // write window decoration configuration as a preset
     for (auto item : skeleton->items()) {
@@ -85,14 +143,29 @@ bool PresetsModel::loadPreset(KCoreConfigSkeleton *skeleton, KConfig *presetsCon
     if (groupName.isEmpty() || !presetsConfig->hasGroup(groupName))
         return false;
 
-    for (KConfigSkeletonItem *item : skeleton->items()) {
-        QString originalGroup = item->group();
-        if (originalGroup == QStringLiteral("Exceptions") || originalGroup == QStringLiteral("Global")) {
-            continue;
+    // applying a preset which has already been decoded is a copy of its values, rather than a read of each key from the config
+    PresetCache &cache = validPresetCache(presetsConfig);
+    auto cachedPreset = cache.presets.constFind(presetName);
+    if (cachedPreset != cache.presets.constEnd()) {
+        for (KConfigSkeletonItem *item : skeleton->items()) {
+            auto value = cachedPreset->constFind(item->key());
+            if (value != cachedPreset->constEnd()) {
+                item->setProperty(value.value());
+            }
+        }
+    } else {
+        PresetValues values;
+        for (KConfigSkeletonItem *item : skeleton->items()) {
+            QString originalGroup = item->group();
+            if (originalGroup == QStringLiteral("Exceptions") || originalGroup == QStringLiteral("Global")) {
+                continue;
+            }
+            item->setGroup(groupName);
+            item->readConfig(presetsConfig);
+            item->setGroup(originalGroup);
+            values.insert(item->key(), item->property());
         }
-        item->setGroup(groupName);
-        item->readConfig(presetsConfig);
-        item->setGroup(originalGroup);
+        cache.presets.insert(presetName, values);
     }
 
     // writes the value of KwinBorderSize from the preset into the kwinrc file
@@ -182,6 +255,7 @@ void PresetsModel::writeBorderSizeToKwinConfig(const QString &borderSize)
 void PresetsModel::deletePreset(KConfig *presetsConfig, const QString &presetName)
 {
     QString groupName = presetGroupName(presetName);
+    invalidatePresetCache();
 
     if (presetsConfig->hasGroup(groupName))
         presetsConfig->deleteGroup(groupName);
@@ -189,6 +263,7 @@ void PresetsModel::deletePreset(KConfig *presetsConfig, const QString &presetNam
 
 void PresetsModel::deleteBundledPresets(KConfig *presetsConfig)
 {
+    invalidatePresetCache();
     QStringList presetList = readPresetsList(presetsConfig);
     for (const QString &presetName : presetList) {
         QString groupName = presetGroupName(presetName);
@@ -316,6 +391,7 @@ PresetsModel::importPreset(KConfig *presetsConfig, const QString &filePath, QStr
     }
 
     // start writing the values
+    invalidatePresetCache();
     auto internalSettings = InternalSettingsPtr(new InternalSettings());
     KConfigGroup configGroup(presetsConfig, importGroupName);
 
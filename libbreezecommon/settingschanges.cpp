@@ -0,0 +1,101 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Paul A McAuley <kde@paulmcauley.com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "settingschanges.h"
+
+#include <KCoreConfigSkeleton>
+
+namespace Breeze
+{
+
+//______________________________________________________________
+SettingsChanges SettingsChangesModel::diff(const KCoreConfigSkeleton *oldSettings, const KCoreConfigSkeleton *newSettings)
+{
+    SettingsChanges changes;
+
+    // both skeletons are of the same generated class, so their items are in the same order
+    const auto oldItems = oldSettings->items();
+    const auto newItems = newSettings->items();
+    if (oldItems.size() != newItems.size()) {
+        return SettingsChangeAll;
+    }
+
+    for (int i = 0; i < newItems.size(); ++i) {
+        if (!newItems[i]->isEqual(oldItems[i]->property())) {
+            changes |= changesForItem(newItems[i]->group(), newItems[i]->key());
+        }
+    }
+
+    return changes;
+}
+
+//______________________________________________________________
+SettingsChanges SettingsChangesModel::diff(const InternalSettingsList &oldExceptions, const InternalSettingsList &newExceptions)
+{
+    if (oldExceptions.size() != newExceptions.size()) {
+        return SettingsChangeAll;
+    }
+
+    for (int i = 0; i < newExceptions.size(); ++i) {
+        for (const QString &key : windecoExceptionKeys) {
+            const KConfigSkeletonItem *oldItem = oldExceptions[i]->findItem(key);
+            const KConfigSkeletonItem *newItem = newExceptions[i]->findItem(key);
+            if (oldItem && newItem && !newItem->isEqual(oldItem->property())) {
+                return SettingsChangeAll;
+            }
+        }
+    }
+
+    return SettingsChangeNone;
+}
+
+//______________________________________________________________
+SettingsChanges SettingsChangesModel::changesForItem(const QString &group, const QString &key)
+{
+    if (group == QStringLiteral("Global") || group == QStringLiteral("SystemIconGeneration")) {
+        // not read by the decoration itself
+        return SettingsChangeNone;
+    } else if (group == QStringLiteral("ShadowStyle")) {
+        // the shadow colour is generated with the decoration colours
+        return SettingsChangeShadow | SettingsChangeColors;
+    } else if (group == QStringLiteral("WindowOutlineStyle")) {
+        // the outline is drawn as part of the shadow
+        return SettingsChangeShadow | SettingsChangeColors;
+    } else if (group == QStringLiteral("ButtonColors") || group == QStringLiteral("ButtonBehaviour")) {
+        return SettingsChangeColors;
+    } else if (group == QStringLiteral("TitleBarOpacity")) {
+        // also affects the opaque state and blur region
+        return SettingsChangeColors | SettingsChangeGeometry;
+    } else if (group == QStringLiteral("TitleBarSpacing")) {
+        return SettingsChangeGeometry;
+    } else if (group == QStringLiteral("ButtonSizing")) {
+        return SettingsChangeGeometry | SettingsChangeButtonIcons;
+    } else if (group == QStringLiteral("Windeco")) {
+        if (key == QStringLiteral("ButtonIconStyle") || key == QStringLiteral("IconSize") || key == QStringLiteral("SystemIconSize")
+            || key == QStringLiteral("BoldButtonIcons")) {
+            // icon sizes also determine the button sizes
+            return SettingsChangeButtonIcons | SettingsChangeGeometry;
+        } else if (key == QStringLiteral("ForceColorizeSystemIcons")) {
+            return SettingsChangeButtonIcons;
+        } else if (key == QStringLiteral("ButtonShape")) {
+            return SettingsChangeGeometry | SettingsChangeButtonIcons | SettingsChangeColors;
+        } else if (key == QStringLiteral("WindowCornerRadius") || key == QStringLiteral("RoundBottomCornersWhenNoBorders")) {
+            return SettingsChangeGeometry | SettingsChangeShadow;
+        } else if (key == QStringLiteral("DrawTitleBarSeparator") || key == QStringLiteral("DrawBorderOnMaximizedWindows")) {
+            return SettingsChangeGeometry;
+        } else if (key == QStringLiteral("DrawBackgroundGradient") || key == QStringLiteral("UseTitleBarColorForAllBorders")
+                   || key == QStringLiteral("ColorizeThinWindowOutlineWithButton")) {
+            return SettingsChangeColors;
+        } else if (key == QStringLiteral("AnimationsEnabled") || key == QStringLiteral("AnimationsSpeedRelativeSystem")) {
+            return SettingsChangeAnimations;
+        }
+    }
+
+    // unknown items, including exception items, could affect anything
+    return SettingsChangeAll;
+}
+
+}
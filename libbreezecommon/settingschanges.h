@@ -0,0 +1,50 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Paul A McAuley <kde@paulmcauley.com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#pragma once
+
+#include "breeze.h"
+#include "breezecommon_export.h"
+
+#include <QFlags>
+
+class KCoreConfigSkeleton;
+
+namespace Breeze
+{
+
+//* parts of the window decoration affected by a settings change, sent from the KCM so that decorations only redo what has changed
+enum BREEZECOMMON_EXPORT SettingsChange {
+    SettingsChangeNone = 0,
+    SettingsChangeShadow = 0x1,
+    SettingsChangeColors = 0x2,
+    SettingsChangeGeometry = 0x4,
+    SettingsChangeButtonIcons = 0x8,
+    SettingsChangeAnimations = 0x10,
+    SettingsChangeAll = SettingsChangeShadow | SettingsChangeColors | SettingsChangeGeometry | SettingsChangeButtonIcons | SettingsChangeAnimations,
+};
+
+Q_DECLARE_FLAGS(SettingsChanges, SettingsChange)
+
+/**
+ * @brief Determines which parts of the window decoration are affected by differences between two configurations
+ */
+class BREEZECOMMON_EXPORT SettingsChangesModel
+{
+public:
+    //* changes between two skeletons of the same class, comparing every item
+    static SettingsChanges diff(const KCoreConfigSkeleton *oldSettings, const KCoreConfigSkeleton *newSettings);
+
+    //* changes between two exception lists; any difference is treated as SettingsChangeAll as exceptions can alter any setting
+    static SettingsChanges diff(const InternalSettingsList &oldExceptions, const InternalSettingsList &newExceptions);
+
+    //* the parts of the decoration affected by the item with the given group and key
+    static SettingsChanges changesForItem(const QString &group, const QString &key);
+};
+
+}
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(Breeze::SettingsChanges)
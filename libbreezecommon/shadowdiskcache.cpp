@@ -0,0 +1,126 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Paul A McAuley <kde@paulmcauley.com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "shadowdiskcache.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <cstring>
+#include <memory>
+
+namespace Breeze
+{
+
+namespace
+{
+//* file header, followed by the pixel data
+struct ShadowDiskCacheHeader {
+    char magic[4];
+    quint32 formatVersion;
+    qint32 width;
+    qint32 height;
+    qint32 bytesPerLine;
+    qint32 format;
+};
+
+constexpr char s_magic[4] = {'K', 'L', 'S', 'H'};
+}
+
+QString ShadowDiskCache::filePath(const QByteArray &key)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArrayLiteral(KLASSY_VERSION));
+    hash.addData(QByteArray::number(s_formatVersion));
+    hash.addData(key);
+
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/klassy/shadows-v%1/").arg(s_formatVersion)
+        + QString::fromLatin1(hash.result().toHex()) + QStringLiteral(".shadow");
+}
+
+QImage ShadowDiskCache::load(const QByteArray &key)
+{
+    auto file = std::make_unique<QFile>(filePath(key));
+    if (!file->open(QIODevice::ReadOnly) || file->size() < qint64(sizeof(ShadowDiskCacheHeader))) {
+        return QImage();
+    }
+
+    // the mapping stays valid for as long as the QFile exists, so the QFile is owned by the returned image
+    const uchar *data = file->map(0, file->size());
+    if (!data) {
+        return QImage();
+    }
+
+    ShadowDiskCacheHeader header;
+    std::memcpy(&header, data, sizeof(header));
+
+    if (std::memcmp(header.magic, s_magic, sizeof(s_magic)) != 0 || header.formatVersion != s_formatVersion
+        || header.format != QImage::Format_ARGB32_Premultiplied || header.width <= 0 || header.height <= 0
+        || header.bytesPerLine < header.width * 4
+        || file->size() != qint64(sizeof(header)) + qint64(header.bytesPerLine) * header.height) {
+        return QImage();
+    }
+
+    QFile *mappedFile = file.release();
+    return QImage(
+        data + sizeof(header),
+        header.width,
+        header.height,
+        header.bytesPerLine,
+        QImage::Format_ARGB32_Premultiplied,
+        [](void *info) {
+            delete static_cast<QFile *>(info);
+        },
+        mappedFile);
+}
+
+void ShadowDiskCache::store(const QByteArray &key, const QImage &image)
+{
+    if (image.isNull()) {
+        return;
+    }
+
+    const QImage texture = image.format() == QImage::Format_ARGB32_Premultiplied ? image : image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+    const QString path = filePath(key);
+    const QString directory = QFileInfo(path).absolutePath();
+    if (!QDir().mkpath(directory)) {
+        return;
+    }
+
+    ShadowDiskCacheHeader header;
+    std::memcpy(header.magic, s_magic, sizeof(s_magic));
+    header.formatVersion = s_formatVersion;
+    header.width = texture.width();
+    header.height = texture.height();
+    header.bytesPerLine = texture.bytesPerLine();
+    header.format = texture.format();
+
+    // QSaveFile writes to a temporary file and renames it on commit, so other processes never see a partially-written texture
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(texture.constBits()), texture.sizeInBytes());
+    if (file.commit()) {
+        prune(directory);
+    }
+}
+
+void ShadowDiskCache::prune(const QString &directory)
+{
+    const QFileInfoList files = QDir(directory).entryInfoList({QStringLiteral("*.shadow")}, QDir::Files, QDir::Time);
+    for (int i = s_maxFiles; i < files.size(); ++i) {
+        QFile::remove(files[i].absoluteFilePath());
+    }
+}
+
+}
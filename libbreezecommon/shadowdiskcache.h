@@ -0,0 +1,45 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Paul A McAuley <kde@paulmcauley.com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#pragma once
+
+#include "breezecommon_export.h"
+
+#include <QByteArray>
+#include <QImage>
+#include <QString>
+
+namespace Breeze
+{
+
+/**
+ * @brief Persistent cache of rendered shadow textures under $XDG_CACHE_HOME/klassy/, shared between KWin and all applications using the Klassy style,
+ *        so that a process start only needs to map a file rather than blur a new shadow.
+ *        The key is the serialized set of all parameters used to render a texture; it is hashed together with the Klassy version and cache format version.
+ */
+class BREEZECOMMON_EXPORT ShadowDiskCache
+{
+public:
+    //* returns the cached texture for the key, memory-mapped read-only from disk, or a null image if not cached
+    static QImage load(const QByteArray &key);
+
+    //* writes the texture to the cache, atomically replacing any existing entry
+    static void store(const QByteArray &key, const QImage &image);
+
+private:
+    //* path of the cache file for the key
+    static QString filePath(const QByteArray &key);
+
+    //* remove the least recently written files when the cache grows beyond s_maxFiles
+    static void prune(const QString &directory);
+
+    //* increment when the file format or rendering changes in a way not covered by the Klassy version
+    static constexpr quint32 s_formatVersion = 1;
+
+    static constexpr int s_maxFiles = 64;
+};
+
+}
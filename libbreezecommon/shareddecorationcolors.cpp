@@ -0,0 +1,199 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Paul A McAuley <kde@paulmcauley.com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "shareddecorationcolors.h"
+
+#include <KConfigSkeleton>
+#include <KStatefulBrush>
+
+#include <QAtomicInteger>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QSharedMemory>
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+
+namespace Breeze
+{
+
+namespace
+{
+//* the colours of a DecorationPaletteGroup, in segment order
+constexpr QColor DecorationPaletteGroup::*s_groupColors[] = {
+    &DecorationPaletteGroup::titleBarBase,
+    &DecorationPaletteGroup::titleBarText,
+    &DecorationPaletteGroup::windowOutline,
+    &DecorationPaletteGroup::shadow,
+    &DecorationPaletteGroup::buttonFocus,
+    &DecorationPaletteGroup::buttonHover,
+    &DecorationPaletteGroup::highlight,
+    &DecorationPaletteGroup::highlightLessSaturated,
+    &DecorationPaletteGroup::negative,
+    &DecorationPaletteGroup::negativeLessSaturated,
+    &DecorationPaletteGroup::negativeSaturated,
+    &DecorationPaletteGroup::fullySaturatedNegative,
+    &DecorationPaletteGroup::neutral,
+    &DecorationPaletteGroup::neutralLessSaturated,
+    &DecorationPaletteGroup::neutralSaturated,
+    &DecorationPaletteGroup::positive,
+    &DecorationPaletteGroup::positiveLessSaturated,
+    &DecorationPaletteGroup::positiveSaturated,
+};
+constexpr int s_groupColorCount = sizeof(s_groupColors) / sizeof(s_groupColors[0]);
+
+struct SharedPaletteGroup {
+    //* bit n set if colour n is valid
+    quint32 validColors;
+    quint64 colors[s_groupColorCount];
+};
+
+struct SharedDecorationColorsSegment {
+    quint32 formatVersion;
+    //* odd while an entry is being written
+    QBasicAtomicInteger<quint32> sequence;
+    char key[20];
+    SharedPaletteGroup active;
+    SharedPaletteGroup inactive;
+};
+
+void toShared(const DecorationPaletteGroup &group, SharedPaletteGroup &shared)
+{
+    shared.validColors = 0;
+    for (int i = 0; i < s_groupColorCount; i++) {
+        const QColor &color = group.*s_groupColors[i];
+        if (color.isValid()) {
+            shared.validColors |= 1u << i;
+        }
+        shared.colors[i] = color.rgba64();
+    }
+}
+
+void fromShared(const SharedPaletteGroup &shared, DecorationPaletteGroup &group)
+{
+    for (int i = 0; i < s_groupColorCount; i++) {
+        group.*s_groupColors[i] = (shared.validColors & (1u << i)) ? QColor(QRgba64::fromRgba64(shared.colors[i])) : QColor();
+    }
+}
+
+//* the process's attachment to the segment, created on first use
+QSharedMemory *segmentMemory()
+{
+    static std::unique_ptr<QSharedMemory> s_memory;
+    if (!s_memory) {
+        // per-user, as the colours depend on the user's settings
+        s_memory = std::make_unique<QSharedMemory>(QStringLiteral("klassy-decorationcolors-%1-%2").arg(qEnvironmentVariable("USER")).arg(KLASSY_VERSION));
+    }
+    return s_memory.get();
+}
+}
+
+QByteArray SharedDecorationColors::key(const QPalette &palette,
+                                       const InternalSettingsPtr &decorationSettings,
+                                       const QColor &titleBarTextActive,
+                                       const QColor &titleBarBaseActive,
+                                       const QColor &titleBarTextInactive,
+                                       const QColor &titleBarBaseInactive,
+                                       const QString &colorSchemePath)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream << s_formatVersion << colorSchemePath << titleBarTextActive << titleBarBaseActive << titleBarTextInactive << titleBarBaseInactive;
+
+    for (int group = 0; group < QPalette::NColorGroups; group++) {
+        for (int role = 0; role < QPalette::NColorRoles; role++) {
+            stream << palette.color(QPalette::ColorGroup(group), QPalette::ColorRole(role));
+        }
+    }
+
+    // the semantic and accent colours are read from kdeglobals rather than the palette
+    for (const KColorScheme::ForegroundRole role : {KColorScheme::NegativeText, KColorScheme::NeutralText, KColorScheme::PositiveText}) {
+        const KStatefulBrush brush(KColorScheme::Button, role);
+        stream << brush.brush(QPalette::Active).color() << brush.brush(QPalette::Inactive).color();
+    }
+    for (const KColorScheme::DecorationRole role : {KColorScheme::FocusColor, KColorScheme::HoverColor}) {
+        const KStatefulBrush brush(KColorScheme::Button, role);
+        stream << brush.brush(QPalette::Active).color() << brush.brush(QPalette::Inactive).color();
+    }
+
+    if (decorationSettings) {
+        const auto items = decorationSettings->items();
+        for (const KConfigSkeletonItem *item : items) {
+            stream << item->key() << item->property();
+        }
+    }
+
+    return QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+}
+
+bool SharedDecorationColors::load(const QByteArray &key, DecorationPaletteGroup &active, DecorationPaletteGroup &inactive)
+{
+    QSharedMemory *memory = segmentMemory();
+    if (!memory->isAttached() && !memory->attach(QSharedMemory::ReadOnly)) {
+        return false;
+    }
+    if (memory->size() < int(sizeof(SharedDecorationColorsSegment))) {
+        return false;
+    }
+
+    const auto *segment = static_cast<const SharedDecorationColorsSegment *>(memory->constData());
+    if (segment->formatVersion != s_formatVersion || key.size() != int(sizeof(segment->key))) {
+        return false;
+    }
+
+    // copy without locking, then check no writer was active during the copy
+    SharedPaletteGroup sharedActive;
+    SharedPaletteGroup sharedInactive;
+    const quint32 sequence = segment->sequence.loadAcquire();
+    if (sequence & 1) {
+        return false;
+    }
+    const bool keyMatches = std::memcmp(segment->key, key.constData(), sizeof(segment->key)) == 0;
+    std::memcpy(&sharedActive, &segment->active, sizeof(SharedPaletteGroup));
+    std::memcpy(&sharedInactive, &segment->inactive, sizeof(SharedPaletteGroup));
+    // keep the copy's reads before the second sequence load
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (segment->sequence.loadRelaxed() != sequence || !keyMatches) {
+        return false;
+    }
+
+    fromShared(sharedActive, active);
+    fromShared(sharedInactive, inactive);
+    return true;
+}
+
+void SharedDecorationColors::store(const QByteArray &key, const DecorationPaletteGroup &active, const DecorationPaletteGroup &inactive)
+{
+    QSharedMemory *memory = segmentMemory();
+
+    // the first producer creates the segment; a read-only attachment must be replaced to write
+    if (memory->isAttached()) {
+        memory->detach();
+    }
+    if (!memory->create(sizeof(SharedDecorationColorsSegment)) && !memory->attach(QSharedMemory::ReadWrite)) {
+        return;
+    }
+    if (memory->size() < int(sizeof(SharedDecorationColorsSegment)) || key.size() != int(sizeof(SharedDecorationColorsSegment::key))) {
+        return;
+    }
+
+    if (!memory->lock()) {
+        return;
+    }
+    auto *segment = static_cast<SharedDecorationColorsSegment *>(memory->data());
+    segment->sequence.fetchAndAddOrdered(1);
+    // keep the entry's writes after the sequence becomes odd
+    std::atomic_thread_fence(std::memory_order_release);
+    segment->formatVersion = s_formatVersion;
+    std::memcpy(segment->key, key.constData(), sizeof(segment->key));
+    toShared(active, segment->active);
+    toShared(inactive, segment->inactive);
+    segment->sequence.fetchAndAddOrdered(1);
+    memory->unlock();
+}
+
+}
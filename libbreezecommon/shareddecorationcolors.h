@@ -0,0 +1,49 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Paul A McAuley <kde@paulmcauley.com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#pragma once
+
+#include "breeze.h"
+#include "breezecommon_export.h"
+#include "decorationcolors.h"
+
+#include <QByteArray>
+#include <QColor>
+#include <QPalette>
+
+namespace Breeze
+{
+
+/**
+ * @brief Decoration colours generated for the application style, published in a shared memory segment so that only the first application to start
+ *        after a colour scheme or settings change needs to generate them.
+ *        The segment holds one entry, keyed by a hash of every input to the colour generation. Writers serialise on the segment's lock; readers never
+ *        lock, and treat the entry as missing if a sequence counter shows it was being written while they read it.
+ */
+class BREEZECOMMON_EXPORT SharedDecorationColors
+{
+public:
+    //* hash of the inputs to DecorationColors::generateDecorationColors()
+    static QByteArray key(const QPalette &palette,
+                          const InternalSettingsPtr &decorationSettings,
+                          const QColor &titleBarTextActive,
+                          const QColor &titleBarBaseActive,
+                          const QColor &titleBarTextInactive,
+                          const QColor &titleBarBaseInactive,
+                          const QString &colorSchemePath);
+
+    //* copies the published colours into active and inactive if they were generated from the key; returns false otherwise
+    static bool load(const QByteArray &key, DecorationPaletteGroup &active, DecorationPaletteGroup &inactive);
+
+    //* publish colours generated from the key, replacing any published entry
+    static void store(const QByteArray &key, const DecorationPaletteGroup &active, const DecorationPaletteGroup &inactive);
+
+private:
+    //* increment when the segment layout changes
+    static constexpr quint32 s_formatVersion = 1;
+};
+
+}